@@ -24,6 +24,14 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# The child selection kernels (selectkernel.h) and the batched rollouts (batchrollout.h) use AVX2 when the compiler targets it.
+# In order to enable them, uncomment the following line.
+#QMAKE_CXXFLAGS += -mavx2
+
+# Counting heap allocations per search phase (allocaudit.h), the counts per playout are printed after each search.
+# In order to enable it, uncomment the following line.
+#DEFINES += ALLOC_AUDIT
+
 
 SOURCES += \
         main.cpp \
@@ -32,12 +40,18 @@ SOURCES += \
     canvas.cpp \
     boarddialog.cpp \
     gamestate.cpp \
+    bitgamestate.cpp \
     cell.cpp \
     aibotbase.cpp \
     randombot.cpp \
     mast.cpp \
+    priorcache.cpp \
+    batchrollout.cpp \
     mctsbot.cpp \
-    evenscheduler.cpp
+    engine.cpp \
+    evenscheduler.cpp \
+    timedscheduler.cpp \
+    allocaudit.cpp
 
 HEADERS += \
         mainwindow.h \
@@ -45,18 +59,38 @@ HEADERS += \
     canvas.h \
     boarddialog.h \
     gamestate.h \
+    unionfind.h \
+    groupscores.h \
+    bitgamestate.h \
     cell.h \
     aibotbase.h \
     randombot.h \
     hmcravenode.h \
     mcts.h \
+    allocaudit.h \
+    searchcontext.h \
+    selectkernel.h \
+    parallelmcts.h \
     zhashtable.h \
     recyclingnode.h \
     node.h \
+    childedge.h \
+    nodepool.h \
     mast.h \
+    sumtree.h \
+    priorcache.h \
+    batchrollout.h \
+    rng.h \
     stopscheduler.h \
+    timedscheduler.h \
+    watchdog.h \
     mctsbot.h \
+    engine.h \
+    gameclock.h \
     evenscheduler.h \
+    playoutbudgetscheduler.h \
+    nodebudgetscheduler.h \
+    relaxed.h \
     uctnode.h
 
 FORMS += \
@@ -1,6 +1,6 @@
 #include "aibotbase.h"
 
-AiBotBase::AiBotBase(GameState* gameState, const QTime* timeLeft):
+AiBotBase::AiBotBase(GameState* gameState, const GameClock* timeLeft):
     QObject(nullptr), // can not have a parent as it will be moved to QThread
     gameState{gameState},
     timeLeft{timeLeft}
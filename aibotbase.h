@@ -1,10 +1,10 @@
 #ifndef AIBOTBASE_H
 #define AIBOTBASE_H
 
+#include "gameclock.h"
 #include "gamestate.h"
 
 #include <vector>
-#include <QTime>
 #include <QThread>
 #include <QObject>
 
@@ -13,7 +13,7 @@ class AiBotBase : public QObject
     Q_OBJECT
     friend class BoardDialog;
 public:
-    AiBotBase(GameState* gameState, const QTime* timeLeft);
+    AiBotBase(GameState* gameState, const GameClock* timeLeft);
     ~AiBotBase()=default;
     void updateGame();
 
@@ -35,9 +35,9 @@ private slots:
 protected:
     GameState* gameState;
     inline bool isTimeOut() const{
-        return timeLeft->toString("m:ss") == "0:00";
+        return timeLeft->remaining() <= 0;
     }
-    const QTime* timeLeft;
+    const GameClock* timeLeft;
     // function should specify whiteMove and blackMove
     virtual void selectBestMoves()=0;
 
@@ -0,0 +1,96 @@
+#include "allocaudit.h"
+
+#ifdef ALLOC_AUDIT
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+thread_local AllocAudit::Phase AllocAudit::currPhase = AllocAudit::Other;
+std::atomic<unsigned long int> AllocAudit::numAllocs[AllocAudit::NumPhases];
+std::atomic<unsigned long int> AllocAudit::numBytes[AllocAudit::NumPhases];
+
+AllocAudit::Scope::Scope(Phase phase):
+    prevPhase{currPhase}
+{
+    currPhase = phase;
+}
+
+AllocAudit::Scope::~Scope()
+{
+    currPhase = prevPhase;
+}
+
+void AllocAudit::clear()
+{
+    for(unsigned int phase = 0; phase < NumPhases; ++phase){
+        numAllocs[phase] = 0;
+        numBytes[phase] = 0;
+    }
+}
+
+void AllocAudit::report(unsigned long int numPlayouts)
+{
+    static const char* names[NumPhases] = {"other", "selection", "expansion", "simulation", "backpropagation",
+                                           "MAST::select", "GameState::update", "GameState::undo"};
+    // printing must not allocate, the counters are still running
+    double denom = numPlayouts > 0 ? numPlayouts : 1;
+    fprintf(stderr, "allocation audit: %lu playouts\n", numPlayouts);
+    for(unsigned int phase = 0; phase < NumPhases; ++phase){
+        fprintf(stderr, "  %-18s %10.3f allocs/playout %12.1f bytes/playout\n", names[phase],
+                numAllocs[phase].load(std::memory_order_relaxed) / denom,
+                numBytes[phase].load(std::memory_order_relaxed) / denom);
+    }
+}
+
+void AllocAudit::count(size_t size)
+{
+    numAllocs[currPhase].fetch_add(1, std::memory_order_relaxed);
+    numBytes[currPhase].fetch_add(size, std::memory_order_relaxed);
+}
+
+// ---- replaceable global allocation functions ----
+// the array and nothrow forms of the standard library call these ones
+
+void* operator new(size_t size)
+{
+    AllocAudit::count(size);
+    void* ptr = malloc(size ? size : 1);
+    if(!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    AllocAudit::count(size);
+    // aligned_alloc needs the size to be a multiple of the alignment
+    size_t alignment = static_cast<size_t>(align);
+    size_t alignedSize = size ? (size + alignment - 1) / alignment * alignment : alignment;
+    void* ptr = aligned_alloc(alignment, alignedSize);
+    if(!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+#endif // ALLOC_AUDIT
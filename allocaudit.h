@@ -0,0 +1,65 @@
+#ifndef ALLOCAUDIT_H
+#define ALLOCAUDIT_H
+
+// Heap allocations are only counted in builds with ALLOC_AUDIT defined, otherwise the macros below are empty.
+
+#ifdef ALLOC_AUDIT
+
+#include <atomic>
+#include <cstddef>
+
+class AllocAudit
+/*
+ * allocation counters of the global operator new, attributed to the innermost phase of the search that is active on
+ * the allocating thread. A search clears the counters when it starts and prints the allocations per playout of each
+ * phase when it finishes.
+ */
+{
+public:
+    enum Phase{
+        Other,
+        Selection,
+        Expansion,
+        Simulation,
+        Backpropagation,
+        PolicySelect,
+        StateUpdate,
+        StateUndo,
+        NumPhases
+    };
+
+    // the phase is active on the current thread until the scope ends
+    class Scope{
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+        Scope(const Scope&)=delete;
+        Scope& operator=(const Scope&)=delete;
+    private:
+        Phase prevPhase;
+    };
+
+    static void clear();
+    static void report(unsigned long int numPlayouts);
+    // called by operator new
+    static void count(size_t size);
+
+private:
+    static thread_local Phase currPhase;
+    static std::atomic<unsigned long int> numAllocs[NumPhases];
+    static std::atomic<unsigned long int> numBytes[NumPhases];
+};
+
+#define ALLOC_AUDIT_SCOPE(phase) AllocAudit::Scope allocAuditScope{AllocAudit::phase}
+#define ALLOC_AUDIT_BEGIN() AllocAudit::clear()
+#define ALLOC_AUDIT_END(numPlayouts) AllocAudit::report(numPlayouts)
+
+#else
+
+#define ALLOC_AUDIT_SCOPE(phase)
+#define ALLOC_AUDIT_BEGIN()
+#define ALLOC_AUDIT_END(numPlayouts) ((void)(numPlayouts))
+
+#endif // ALLOC_AUDIT
+
+#endif // ALLOCAUDIT_H
@@ -0,0 +1,143 @@
+#include "batchrollout.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// ---- (re-)initializations ----
+
+BatchRollout::BatchRollout(GameState* gameState):
+    gameState{gameState},
+    cellNum{0},
+    scores{0},
+    rng{Rng::RolloutStream}
+{
+    setup();
+}
+
+void BatchRollout::setup(){
+    if(cellNum == gameState->cellNum)
+        return;
+    cellNum = gameState->cellNum;
+    neighbours.assign(cellNum * maxNeighbours, 0);
+    for(unsigned int cellIdx = 0; cellIdx < cellNum; ++cellIdx){
+        vector<unsigned int> idxs = gameState->neighbourIdxs(cellIdx);
+        for(unsigned int i = 0; i < maxNeighbours; ++i)
+            neighbours[cellIdx * maxNeighbours + i] = i < idxs.size() ? idxs[i] : cellIdx;
+    }
+    colors.assign(cellNum * numLanes, EMPTY);
+    labels.assign(cellNum * numLanes, 0);
+    freeCells.reserve(cellNum);
+    groupSizes.assign(cellNum, 0);
+    scores = GroupScores{cellNum};
+}
+
+// ---- playouts ----
+
+double BatchRollout::run(){
+    fillBoards();
+    labelGroups();
+    double outcome = 0;
+    for(unsigned int lane = 0; lane < numLanes; ++lane)
+        outcome += scoreLane(lane);
+    return outcome / numLanes;
+}
+
+void BatchRollout::fillBoards(){
+    // the stones of the leaf are the same in each lane
+    freeCells.clear();
+    for(unsigned int cellIdx = 0; cellIdx < cellNum; ++cellIdx){
+        Color color = gameState->cellColor(cellIdx);
+        if(color == EMPTY)
+            freeCells.push_back(cellIdx);
+        fill(colors.begin() + cellIdx * numLanes, colors.begin() + (cellIdx + 1) * numLanes, color);
+    }
+    // the pieces alternate in color from the current one, the cells left over stay empty
+    unsigned int numMoves = gameState->numRemainingMoves();
+    Color colorSeq[2] = {gameState->getCurrentColor(), gameState->getCurrentColor() == WHITE ? BLACK : WHITE};
+    for(unsigned int lane = 0; lane < numLanes; ++lane){
+        // a partial shuffle of the previous lane's order is still uniform
+        for(unsigned int i = 0; i < numMoves; ++i){
+            swap(freeCells[i], freeCells[i + rng.below(freeCells.size() - i)]);
+            colors[freeCells[i] * numLanes + lane] = colorSeq[i % 2];
+        }
+    }
+}
+
+void BatchRollout::labelGroups(){
+    for(unsigned int cellIdx = 0; cellIdx < cellNum; ++cellIdx)
+        fill(labels.begin() + cellIdx * numLanes, labels.begin() + (cellIdx + 1) * numLanes, cellIdx);
+    // alternating sweeps carry the labels along the groups in both directions until no label changes
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(unsigned int cellIdx = 0; cellIdx < cellNum; ++cellIdx)
+            changed |= relax(cellIdx);
+        for(unsigned int cellIdx = cellNum; cellIdx-- > 0;)
+            changed |= relax(cellIdx);
+    }
+}
+
+inline bool BatchRollout::relax(unsigned int cellIdx){
+    const uint16_t* cellColors = colors.data() + cellIdx * numLanes;
+    uint16_t* cellLabels = labels.data() + cellIdx * numLanes;
+    const uint16_t* cellNeighbours = neighbours.data() + cellIdx * maxNeighbours;
+#ifdef __AVX2__
+    const __m256i vColor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cellColors));
+    const __m256i vEmpty = _mm256_cmpeq_epi16(vColor, _mm256_set1_epi16(EMPTY));
+    const __m256i vPrev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cellLabels));
+    __m256i vLabel = vPrev;
+    for(unsigned int i = 0; i < maxNeighbours; ++i){
+        unsigned int offset = cellNeighbours[i] * numLanes;
+        __m256i vNColor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(colors.data() + offset));
+        __m256i vNLabel = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(labels.data() + offset));
+        // lanes where both cells hold a stone of the same color
+        __m256i same = _mm256_andnot_si256(vEmpty, _mm256_cmpeq_epi16(vColor, vNColor));
+        vLabel = _mm256_blendv_epi8(vLabel, _mm256_min_epu16(vLabel, vNLabel), same);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cellLabels), vLabel);
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi16(vLabel, vPrev)) != -1;
+#else
+    // local copies without aliasing and branchless lanes let the compiler vectorize with the baseline instruction set
+    uint16_t color[numLanes];
+    uint16_t label[numLanes];
+    copy(cellColors, cellColors + numLanes, color);
+    copy(cellLabels, cellLabels + numLanes, label);
+    for(unsigned int i = 0; i < maxNeighbours; ++i){
+        const uint16_t* nColors = colors.data() + cellNeighbours[i] * numLanes;
+        const uint16_t* nLabels = labels.data() + cellNeighbours[i] * numLanes;
+        for(unsigned int lane = 0; lane < numLanes; ++lane){
+            uint16_t same = -static_cast<uint16_t>((color[lane] != EMPTY) & (color[lane] == nColors[lane]));
+            uint16_t minLabel = nLabels[lane] < label[lane] ? nLabels[lane] : label[lane];
+            label[lane] = (minLabel & same) | (label[lane] & ~same);
+        }
+    }
+    uint16_t changed = 0;
+    for(unsigned int lane = 0; lane < numLanes; ++lane){
+        changed |= label[lane] ^ cellLabels[lane];
+        cellLabels[lane] = label[lane];
+    }
+    return changed != 0;
+#endif
+}
+
+double BatchRollout::scoreLane(unsigned int lane){
+    for(unsigned int cellIdx = 0; cellIdx < cellNum; ++cellIdx){
+        if(colors[cellIdx * numLanes + lane] != EMPTY)
+            ++groupSizes[labels[cellIdx * numLanes + lane]];
+    }
+    // a group is labelled with its smallest cell
+    scores.clear();
+    for(unsigned int cellIdx = 0; cellIdx < cellNum; ++cellIdx){
+        if(groupSizes[cellIdx] == 0)
+            continue;
+        scores.add(static_cast<Color>(colors[cellIdx * numLanes + lane]), groupSizes[cellIdx]);
+        groupSizes[cellIdx] = 0;
+    }
+    int order = scores.compare();
+    if(order > 0)
+        return 1.0;
+    else if(order < 0)
+        return 0.0;
+    return 0.5;
+}
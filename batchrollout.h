@@ -0,0 +1,57 @@
+#ifndef BATCHROLLOUT_H
+#define BATCHROLLOUT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "gamestate.h"
+#include "groupscores.h"
+#include "rng.h"
+
+using namespace std;
+
+class BatchRollout
+/*
+ * numLanes uniformly random playouts from the same leaf played in lockstep. The outcome of a playout only depends on
+ * the final board, and a random playout fills the empty cells with a random permutation of the remaining pieces, so
+ * each lane draws its final board directly. The boards are stored as structure of arrays, the lanes of a cell are
+ * contiguous, and the groups of all lanes are labelled together by propagating the smallest cell index between
+ * neighbours of the same color, one vector instruction per neighbour for every lane. The lanes are then scored one by
+ * one from the group sizes.
+ */
+{
+public:
+    // 16 bit labels of 16 lanes fill an AVX2 register
+    static constexpr unsigned int numLanes = 16;
+
+    explicit BatchRollout(GameState* gameState);
+    BatchRollout(const BatchRollout&)=delete;
+    BatchRollout& operator=(const BatchRollout&)=delete;
+    // the board size of gameState may have changed
+    void setup();
+    // white: 1 black: 0 draw 0.5, averaged over the lanes
+    double run();
+
+private:
+    // a cell has at most 6 neighbours, missing ones are padded with the cell itself
+    static constexpr unsigned int maxNeighbours = 6;
+
+    void fillBoards();
+    void labelGroups();
+    // relaxes the labels of a cell from its neighbours in each lane, true if a label decreased
+    inline bool relax(unsigned int cellIdx);
+    double scoreLane(unsigned int lane);
+
+    GameState* gameState;
+    unsigned int cellNum;
+    vector<uint16_t> neighbours;
+    // colors[cellIdx * numLanes + lane] and labels[cellIdx * numLanes + lane]
+    vector<uint16_t> colors;
+    vector<uint16_t> labels;
+    vector<unsigned int> freeCells;
+    vector<unsigned int> groupSizes;
+    GroupScores scores;
+    Rng rng;
+};
+
+#endif // BATCHROLLOUT_H
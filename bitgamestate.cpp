@@ -0,0 +1,476 @@
+#include "bitgamestate.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <thread>
+
+#define assertm(exp, msg) assert(((void)msg, exp))
+
+// ---- (re-)initializations ----
+
+BitGameState::BitGameState(int boardSize):
+    cellNum{computeCellNum(boardSize)},
+    boardSize{boardSize},
+    numWords{(cellNum + 63) / 64},
+    rng{Rng::StateStream},
+    neighbours(cellNum, Bits{}),
+    roots(cellNum),
+    groups(cellNum, Bits{}),
+    groupSizes(cellNum),
+    moveIdxs(cellNum),
+    moveStamps(cellNum),
+    numUpdates{0},
+    merges(cellNum),
+    playerScores{cellNum},
+    validMoves{this}
+{
+    assertm(numWords <= maxWords, "the board does not fit into the bitboards");
+    initNeighbours();
+    reset();
+}
+
+BitGameState::BitGameState(const BitGameState& other):
+    cellNum{other.cellNum},
+    boardSize{other.boardSize},
+    numWords{other.numWords},
+    rng{other.rng},
+    neighbours{other.neighbours},
+    board{other.board},
+    roots{other.roots},
+    groups{other.groups},
+    groupSizes{other.groupSizes},
+    moveIdxs{other.moveIdxs},
+    moveStamps{other.moveStamps},
+    numUpdates{other.numUpdates},
+    merges{other.merges},
+    numMoves{other.numMoves},
+    playerScores{other.playerScores},
+    numSteps{other.numSteps},
+    currentColor{other.currentColor},
+    currentPlayer{other.currentPlayer},
+    validMoves{this}
+{}
+
+void BitGameState::reset(){
+    board[WHITE].fill(0);
+    board[BLACK].fill(0);
+    board[EMPTY].fill(0);
+    for(unsigned int idx = 0; idx < cellNum; ++idx)
+        set(board[EMPTY], idx);
+    numMoves = 0;
+    playerScores.clear();
+    // each player should have equal moves so we divide by 4
+    numSteps = cellNum - cellNum%4;
+    currentColor = WHITE;
+    currentPlayer = WHITE;
+}
+
+unsigned int BitGameState::computeCellNum(unsigned int boardSize) const{
+    unsigned int numRows = 2*boardSize-1;
+    return boardSize*numRows+(numRows-3)/2*((numRows-3)/2+1)+boardSize-1;
+}
+
+void BitGameState::initNeighbours(){
+    // cells are indexed row-by-row like in GameState, the first index of each row of axial q is kept for the lookup
+    auto isValid = [this](int q, int r){
+        return std::abs(q)<=boardSize-1 and std::abs(r)<=boardSize-1 and std::abs(q + r)<=boardSize-1;
+    };
+    vector<int> rowStart;
+    unsigned int idx = 0;
+    for(int q = -boardSize+1; q < boardSize; ++q){
+        rowStart.push_back(idx);
+        idx += 2*boardSize-1 - std::abs(q);
+    }
+    auto toIdx = [&](int q, int r){
+        return rowStart[q+boardSize-1] + (q >= 0? r+boardSize-1: r+boardSize-1+q);
+    };
+    const int dirs[6][2] = {{-1, 1}, {-1, 0}, {0, -1}, {1, -1}, {1, 0}, {0, 1}};
+    for(int q = -boardSize+1; q < boardSize; ++q){
+        for(int r = -boardSize+1; r < boardSize; ++r){
+            if(!isValid(q, r))
+                continue;
+            for(auto& dir : dirs){
+                if(isValid(q + dir[0], r + dir[1]))
+                    set(neighbours[toIdx(q, r)], toIdx(q + dir[0], r + dir[1]));
+            }
+        }
+    }
+}
+
+// ---- forward updates ----
+
+void BitGameState::update(unsigned int moveIdx){
+    moveStamps[numMoves] = ++numUpdates;
+    moveIdxs[numMoves++] = moveIdx;
+    unsigned int cellIdx = moveIdx%cellNum;
+    clear(board[EMPTY], cellIdx);
+    set(board[currentColor], cellIdx);
+    mergeGroups(cellIdx, currentColor);
+    --numSteps;
+    updateColors();
+}
+
+void BitGameState::updateColors(){
+    if(currentColor == WHITE)
+        currentColor = BLACK;
+    else{
+        currentPlayer = currentPlayer == WHITE? BLACK : WHITE;
+        currentColor = WHITE;
+    }
+}
+
+void BitGameState::mergeGroups(unsigned int cellIdx, Color color)
+{
+    Merge& merge = merges[numMoves-1];
+    merge.numGroups = 0;
+    // stones of the same color around the cell, a found group removes all of its stones at once
+    Bits adjacent;
+    unsigned int numGroups = 0;
+    unsigned int nRoots[3];
+    for(unsigned int i = 0; i < numWords; ++i)
+        adjacent[i] = neighbours[cellIdx][i] & board[color][i];
+    for(unsigned int i = 0; i < numWords; ++i){
+        while(adjacent[i]){
+            unsigned int nRoot = roots[i * 64 + __builtin_ctzll(adjacent[i])];
+            nRoots[numGroups++] = nRoot;
+            for(unsigned int j = i; j < numWords; ++j)
+                adjacent[j] &= ~groups[nRoot][j];
+        }
+    }
+
+    if(numGroups == 0){
+        playerScores.add(color, 1);
+        roots[cellIdx] = cellIdx;
+        groupSizes[cellIdx] = 1;
+        groups[cellIdx].fill(0);
+        set(groups[cellIdx], cellIdx);
+        merge.root = cellIdx;
+        return;
+    }
+
+    // the largest group keeps its root so the fewest stones are relabelled
+    unsigned int* largest = std::max_element(nRoots, nRoots + numGroups, [this](unsigned int a, unsigned int b){
+        return groupSizes[a] < groupSizes[b];
+    });
+    std::swap(*largest, nRoots[0]);
+    unsigned int root = nRoots[0];
+    merge.root = root;
+
+    unsigned int newGroupSize = 1;
+    for(unsigned int i = 0; i < numGroups; ++i){
+        newGroupSize += groupSizes[nRoots[i]];
+        playerScores.remove(color, groupSizes[nRoots[i]]);
+    }
+    for(unsigned int i = 1; i < numGroups; ++i){
+        unsigned int nRoot = nRoots[i];
+        merge.groups[merge.numGroups++] = nRoot;
+        for(unsigned int j = 0; j < numWords; ++j)
+            groups[root][j] |= groups[nRoot][j];
+        relabel(groups[nRoot], root);
+    }
+    set(groups[root], cellIdx);
+    roots[cellIdx] = root;
+    groupSizes[root] = newGroupSize;
+    playerScores.add(color, newGroupSize);
+}
+
+// ---- backward updates ----
+
+void BitGameState::undo()
+{
+    // we expect that the caller do not call when there is no taken cells
+    unsigned int cellIdx = lastTakenCellIdx();
+    undoColors();
+    clear(board[currentColor], cellIdx);
+    set(board[EMPTY], cellIdx);
+    decomposeGroup(cellIdx, currentColor);
+    ++numSteps;
+    --numMoves;
+}
+
+void BitGameState::undoColors(){
+    if(currentColor == WHITE){
+        currentColor = BLACK;
+        currentPlayer = currentPlayer == WHITE? BLACK : WHITE;
+    }
+    else
+        currentColor = WHITE;
+}
+
+void BitGameState::decomposeGroup(unsigned int cellIdx, Color color)
+{
+    const Merge& merge = merges[numMoves-1];
+    unsigned int root = merge.root;
+
+    playerScores.remove(color, groupSizes[root]);
+    // single stone, a merged stone is never the root of its group
+    if(root == cellIdx)
+        return;
+
+    clear(groups[root], cellIdx);
+    --groupSizes[root];
+    // restore the joined groups, their masks and sizes were left untouched
+    for(unsigned int i = 0; i < merge.numGroups; ++i){
+        unsigned int nRoot = merge.groups[i];
+        for(unsigned int j = 0; j < numWords; ++j)
+            groups[root][j] &= ~groups[nRoot][j];
+        relabel(groups[nRoot], nRoot);
+        groupSizes[root] -= groupSizes[nRoot];
+        playerScores.add(color, groupSizes[nRoot]);
+    }
+    playerScores.add(color, groupSizes[root]);
+}
+
+// ---- bit manipulations ----
+
+inline bool BitGameState::test(const Bits& bits, unsigned int idx){
+    return bits[idx / 64] >> (idx % 64) & 1;
+}
+
+inline void BitGameState::set(Bits& bits, unsigned int idx){
+    bits[idx / 64] |= uint64_t(1) << (idx % 64);
+}
+
+inline void BitGameState::clear(Bits& bits, unsigned int idx){
+    bits[idx / 64] &= ~(uint64_t(1) << (idx % 64));
+}
+
+inline void BitGameState::relabel(const Bits& group, unsigned int root){
+    for(unsigned int i = 0; i < numWords; ++i){
+        for(uint64_t word = group[i]; word; word &= word - 1)
+            roots[i * 64 + __builtin_ctzll(word)] = root;
+    }
+}
+
+// ---- queries ----
+
+Color BitGameState::leader(){
+    int order = playerScores.compare();
+    if(order > 0)
+        return WHITE;
+    else if(order < 0)
+        return BLACK;
+    return EMPTY;
+}
+
+Color BitGameState::getCurrentColor() const{
+    return currentColor;
+}
+
+bool BitGameState::end() const{
+    return numSteps == 0;
+}
+
+map<Color, double> BitGameState::getPlayerScores() const{
+    return {{WHITE, playerScores.score(WHITE)}, {BLACK, playerScores.score(BLACK)}};
+}
+
+double BitGameState::getScore(){
+    int order = playerScores.compare();
+    if(order > 0)
+        return 1.0;
+    else if(order < 0)
+        return 0.0;
+    return 0.5;
+}
+
+int BitGameState::getBoardSize() const{
+    return boardSize;
+}
+
+Color BitGameState::getCurrentPlayer() const{
+    return currentPlayer;
+}
+
+Color BitGameState::getPreviousPlayer() const{
+    // the player who placed the last piece, a turn is two pieces
+    if(numMoves == 0)
+        return WHITE;
+    return (numMoves-1)/2%2 == 0? WHITE : BLACK;
+}
+
+unsigned int BitGameState::takenMove() const{
+    return moveIdxs[numMoves-1];
+}
+
+unsigned int BitGameState::numTakenMoves() const{
+    return numMoves;
+}
+
+unsigned int BitGameState::takenMove(unsigned int i) const{
+    return moveIdxs[i];
+}
+
+unsigned long int BitGameState::moveStamp(unsigned int i) const{
+    return moveStamps[i];
+}
+
+unsigned int BitGameState::numExpectedMoves() const{
+    return (numSteps + 2) / 4;
+}
+
+unsigned int BitGameState::getRandomMove() const {
+    return validMoves.getRandomMove();
+}
+
+unsigned int BitGameState::getBlackCell() const {
+    // we expect the function to be called after at least one black piece has been put
+    return moveIdxs[numMoves%2==1? numMoves-2: numMoves-1] - cellNum;
+}
+
+unsigned int BitGameState::getWhiteCell() const {
+    // we expect the function to be called after at least one black piece has been put
+    return moveIdxs[numMoves%2==0? numMoves-2: numMoves-1];
+}
+
+unsigned int BitGameState::moveNum() const{
+    return cellNum*2;
+}
+
+unsigned int BitGameState::toMoveIdx(unsigned int cellIdx, unsigned int pieceIdx) const{
+    // for Omega color alone identifies piece type
+    return cellIdx + pieceIdx * cellNum;
+}
+
+unsigned int BitGameState::lastTakenCellIdx() const{
+    return moveIdxs[numMoves-1]%cellNum;
+}
+
+Color BitGameState::cellColor(unsigned int cellIdx) const{
+    if(test(board[WHITE], cellIdx))
+        return WHITE;
+    if(test(board[BLACK], cellIdx))
+        return BLACK;
+    return EMPTY;
+}
+
+unsigned int BitGameState::groupSize(unsigned int cellIdx) const{
+    if(cellColor(cellIdx) == EMPTY)
+        return 0;
+    return groupSizes[roots[cellIdx]];
+}
+
+vector<unsigned int> BitGameState::neighbourIdxs(unsigned int cellIdx) const{
+    vector<unsigned int> idxs;
+    for(unsigned int i = 0; i < numWords; ++i){
+        for(uint64_t word = neighbours[cellIdx][i]; word; word &= word - 1)
+            idxs.push_back(i * 64 + __builtin_ctzll(word));
+    }
+    return idxs;
+}
+
+unsigned int BitGameState::numRemainingMoves() const{
+    return numSteps;
+}
+
+array<vector<double>, 2> BitGameState::getInitialPolicy(uint64_t seed, unsigned int numThreads){
+    // compute initial policy by simulating n random playouts and averaging the results based on the outcome
+    unsigned int n = numPriorPlayouts;
+    if(numThreads == 0)
+        numThreads = max(thread::hardware_concurrency(), 1u);
+    numThreads = min(numThreads, numPriorStreams);
+    // stream i of the seed plays the i-th share of the playouts, the workers take the streams in turn on their own copy
+    vector<vector<double>> outcomes(numPriorStreams, vector<double>(cellNum*2, 0.0));
+    vector<vector<double>> counts(numPriorStreams, vector<double>(cellNum*2, 0.0));
+    auto work = [&](BitGameState* worker, unsigned int first){
+        for(unsigned int i = first; i < numPriorStreams; i += numThreads){
+            worker->rng = Rng{seed, i};
+            unsigned int numPlayouts = n / numPriorStreams + (i < n % numPriorStreams);
+            worker->playRandomGames(numPlayouts, outcomes[i], counts[i]);
+        }
+    };
+    vector<unique_ptr<BitGameState>> workers;
+    for(unsigned int i = 0; i < numThreads; ++i)
+        workers.push_back(make_unique<BitGameState>(*this));
+    vector<thread> threads;
+    threads.reserve(numThreads);
+    for(unsigned int i = 0; i < numThreads; ++i)
+        threads.emplace_back(work, workers[i].get(), i);
+    for(auto& t : threads)
+        t.join();
+    // each score starts from 0.5 with the weight of one playout, the streams are merged in order so the sums are
+    // reproducible for a given seed
+    array<vector<double>, 2> scores = {vector<double>(cellNum*2), vector<double>(cellNum*2)};
+    for(unsigned int moveIdx = 0; moveIdx < cellNum*2; ++moveIdx){
+        double outcome = 0.5;
+        double count = 1.0;
+        for(unsigned int i = 0; i < numPriorStreams; ++i){
+            outcome += outcomes[i][moveIdx];
+            count += counts[i][moveIdx];
+        }
+        scores[WHITE][moveIdx] = outcome / count;
+        scores[BLACK][moveIdx] = (count - outcome) / count;
+    }
+    return scores;
+}
+
+void BitGameState::playRandomGames(unsigned int n, vector<double>& outcomes, vector<double>& counts){
+    vector<unsigned int> cellIdxs;
+    cellIdxs.reserve(cellNum);
+    for(unsigned int idx = 0; idx < cellNum; ++idx)
+        cellIdxs.push_back(idx);
+    unsigned int startMove = numMoves;
+    for(unsigned int i = 0; i < n; ++i){
+        shuffle(cellIdxs.begin(), cellIdxs.end(), rng);
+        unsigned int idx = 0;
+        while(numSteps > 0){
+            if(test(board[EMPTY], cellIdxs[idx]))
+                update(cellIdxs[idx] + cellNum * currentColor);
+            ++idx;
+        }
+        double outcome = getScore();
+        while(numMoves > startMove){
+            unsigned int moveIdx = takenMove();
+            undo();
+            outcomes[moveIdx] += outcome;
+            ++counts[moveIdx];
+        }
+    }
+}
+
+// ---- member variable providing the available moves for each state ----
+
+BitGameState::ValidMoves::ValidMoves(const BitGameState* parent):
+    parent{parent}
+{}
+
+unsigned int BitGameState::ValidMoves::size() const{
+    unsigned int sum = 0;
+    for(unsigned int i = 0; i < parent->numWords; ++i)
+        sum += __builtin_popcountll(parent->board[EMPTY][i]);
+    return sum;
+}
+
+unsigned int BitGameState::ValidMoves::getRandomMove() const {
+    // the n-th empty cell
+    unsigned int n = parent->rng.below(size());
+    for(unsigned int i = 0; i < parent->numWords; ++i){
+        uint64_t word = parent->board[EMPTY][i];
+        unsigned int wordSize = __builtin_popcountll(word);
+        if(n < wordSize){
+            for(; n > 0; --n)
+                word &= word - 1;
+            return i * 64 + __builtin_ctzll(word) + parent->cellNum * parent->currentColor;
+        }
+        n -= wordSize;
+    }
+    return 0;
+}
+
+BitGameState::ValidMoves::Iterator::Iterator(const ValidMoves* parent, unsigned int wordIdx):
+    parent{parent},
+    wordIdx{wordIdx},
+    word{wordIdx < parent->parent->numWords? parent->parent->board[EMPTY][wordIdx]: 0}
+{
+    skipEmptyWords();
+}
+
+void BitGameState::ValidMoves::Iterator::skipEmptyWords(){
+    // the end iterator is at wordIdx == numWords with no bits left
+    while(word == 0 and wordIdx < parent->parent->numWords){
+        ++wordIdx;
+        if(wordIdx < parent->parent->numWords)
+            word = parent->parent->board[EMPTY][wordIdx];
+    }
+}
@@ -0,0 +1,193 @@
+#ifndef BITGAMESTATE_H
+#define BITGAMESTATE_H
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "cell.h"
+#include "groupscores.h"
+#include "rng.h"
+
+class BitGameState
+/*
+ * Omega game state on bitboards, an alternative of GameState with the same interface for the search. The stones of a
+ * color are a few 64 bit words, each cell has a precomputed mask of its neighbours. A group is stored as a mask at its
+ * root cell, connecting a stone merges the masks of the neighbour groups and the sizes come from popcounts. Merges are
+ * kept in a log of fixed size so update() and undo() do not allocate.
+ */
+{
+public:
+    // boards up to maxBoardSize fit into maxWords words
+    static constexpr unsigned int maxWords = 8;
+    static constexpr int maxBoardSize = 13;
+    typedef array<uint64_t, maxWords> Bits;
+
+    BitGameState(int boardSize);
+    // validMoves refers to its own state so it is not copied
+    BitGameState(const BitGameState& other);
+    BitGameState& operator=(const BitGameState&)=delete;
+
+    unsigned int computeCellNum(unsigned int boardSize) const;
+
+    void reset();
+
+    // cellNum should be declared before the masks!
+    const unsigned int cellNum;
+    int getBoardSize() const;
+    Color getCurrentPlayer() const;
+    Color getPreviousPlayer() const;
+    Color getCurrentColor() const;
+    bool end() const;
+    Color leader();
+    double getScore();
+    void update(unsigned int moveIdx);
+    void undo();
+    // takes the moves of another state with the same interface, e.g. the game state of the search. Only the moves after
+    // the common start of both games are undone and played again
+    template<typename StateType>
+    void follow(const StateType& other);
+    // the scores are rounded when they do not fit into a double
+    map<Color, double> getPlayerScores() const;
+    unsigned int takenMove() const;
+    // moves taken from the empty board, the stamp of a move is unique so a move taken again after an undo differs
+    unsigned int numTakenMoves() const;
+    unsigned int takenMove(unsigned int i) const;
+    unsigned long int moveStamp(unsigned int i) const;
+    unsigned int numExpectedMoves() const;
+    unsigned int getRandomMove() const;
+    unsigned int getWhiteCell() const;
+    unsigned int getBlackCell() const;
+    unsigned int moveNum() const;
+    unsigned int toMoveIdx(unsigned int cellIdx, unsigned int pieceIdx) const;
+    unsigned int lastTakenCellIdx() const;
+    Color cellColor(unsigned int cellIdx) const;
+    // stones in the group of the cell, 0 for an empty cell
+    unsigned int groupSize(unsigned int cellIdx) const;
+    // indices of the neighbour cells in increasing order
+    vector<unsigned int> neighbourIdxs(unsigned int cellIdx) const;
+    // pieces left to place until the end of the game
+    unsigned int numRemainingMoves() const;
+    // number of random playouts of the initial policy, split into a fixed number of streams of the seed
+    static constexpr unsigned int numPriorPlayouts = 50000;
+    static constexpr unsigned int numPriorStreams = 64;
+    // averaged outcomes of random playouts per move, computed by numThreads workers (0 uses every core). The result
+    // only depends on the seed, not on the number of workers
+    array<vector<double>, 2> getInitialPolicy(uint64_t seed, unsigned int numThreads=0);
+
+private:
+    // ---- available moves ----
+    class ValidMoves
+    {
+        // the empty cells of the board, iterated in cell order
+    public:
+        ValidMoves(const BitGameState* parent);
+        unsigned int getRandomMove() const;
+        unsigned int size() const;
+
+        struct Iterator
+        {
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = unsigned int;
+            using pointer           = const uint64_t*;
+            using reference         = unsigned int&;
+
+            Iterator(const ValidMoves* parent, unsigned int wordIdx);
+
+            value_type operator*() const { return wordIdx * 64 + __builtin_ctzll(word) + parent->parent->cellNum * parent->parent->currentColor; }
+            Iterator& operator++() { word &= word - 1; skipEmptyWords(); return *this; }
+            Iterator operator++(int) { Iterator tmp = *this; ++(*this); return tmp; }
+            friend bool operator== (const Iterator& a, const Iterator& b) { return a.wordIdx == b.wordIdx and a.word == b.word; }
+            friend bool operator!= (const Iterator& a, const Iterator& b) { return !(a == b); }
+
+        private:
+            void skipEmptyWords();
+
+            const ValidMoves* parent;
+            unsigned int wordIdx;
+            // bits of the current word that are not visited yet
+            uint64_t word;
+        };
+
+        Iterator begin() const { return Iterator(this, 0); }
+        Iterator end() const { return Iterator(this, parent->numWords); }
+
+    private:
+        const BitGameState* parent;
+    };
+
+    struct Merge{
+        // root of the merged group, groups[0] and groups[1] are the other roots joined into it
+        unsigned int root;
+        unsigned int groups[2];
+        unsigned int numGroups;
+    };
+
+    // ---- initialization ----
+    void initNeighbours();
+
+    // ---- forward update ----
+    void mergeGroups(unsigned int cellIdx, Color color);
+    void updateColors();
+
+    // ---- backward update ----
+    void decomposeGroup(unsigned int cellIdx, Color color);
+    void undoColors();
+
+    // ---- initial policy ----
+    // outcome sums and counts per move of n random playouts from the current state, the state is restored
+    void playRandomGames(unsigned int n, vector<double>& outcomes, vector<double>& counts);
+
+    // ---- bit manipulations ----
+    inline static bool test(const Bits& bits, unsigned int idx);
+    inline static void set(Bits& bits, unsigned int idx);
+    inline static void clear(Bits& bits, unsigned int idx);
+    // root of every cell of the group becomes root
+    inline void relabel(const Bits& group, unsigned int root);
+
+    // ---- variables ----
+
+    const int boardSize;
+    const unsigned int numWords;
+    // getRandomMove() is const
+    mutable Rng rng;
+    vector<Bits> neighbours;
+    // stones per color and the empty cells
+    array<Bits, 3> board;
+
+    // root cell of the group of a stone, the cells and the size of a group are stored at its root
+    vector<unsigned int> roots;
+    vector<Bits> groups;
+    vector<unsigned int> groupSizes;
+
+    // one entry per move, filled up to the number of taken cells
+    vector<unsigned int> moveIdxs;
+    vector<unsigned long int> moveStamps;
+    unsigned long int numUpdates;
+    vector<Merge> merges;
+    unsigned int numMoves;
+
+    GroupScores playerScores;
+    unsigned int numSteps;
+    Color currentColor;
+    Color currentPlayer;
+public:
+    ValidMoves validMoves;
+};
+
+template<typename StateType>
+void BitGameState::follow(const StateType& other){
+    unsigned int numOtherMoves = other.numTakenMoves();
+    unsigned int numShared = 0;
+    while(numShared < numMoves and numShared < numOtherMoves and moveIdxs[numShared] == other.takenMove(numShared))
+        ++numShared;
+    while(numMoves > numShared)
+        undo();
+    while(numMoves < numOtherMoves)
+        update(other.takenMove(numMoves));
+}
+
+#endif // BITGAMESTATE_H
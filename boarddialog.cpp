@@ -23,8 +23,6 @@ BoardDialog::BoardDialog(
     time{time},
     inGame{false},
     gameState{boardSize, GameState::FeatureFlags::FreeNeighbours},
-    rTimeWhite{0},
-    rTimeBlack{0},
     whiteTimer{nullptr},
     blackTimer{nullptr},
     currPlayer{WHITE}
@@ -42,9 +40,9 @@ BoardDialog::BoardDialog(
 
     if(mode == "vs AI"){
         if(bot == "MCTS")
-            aiBot = new MCTSBot(&gameState, playerColor == Color::WHITE? &timeBlack : &timeWhite, node, recycling, budget);
+            aiBot = new MCTSBot(&gameState, playerColor == Color::WHITE? &clockBlack : &clockWhite, node, recycling, budget);
         else if(bot == "Random")
-            aiBot = new RandomBot(&gameState, playerColor == Color::WHITE? &timeBlack : &timeWhite);
+            aiBot = new RandomBot(&gameState, playerColor == Color::WHITE? &clockBlack : &clockWhite);
         connect(&(aiBot->thread), SIGNAL (finished()), this, SLOT(updateFromAiBot()));
     }
     else aiBot = nullptr;
@@ -56,59 +54,58 @@ BoardDialog::~BoardDialog()
     delete ui;
 }
 
+// countdown label of a clock
+static QString countdownText(long int msecs){
+    return QTime(0, 0).addMSecs(msecs > 0 ? msecs : 0).toString("m:ss");
+}
+
 void BoardDialog::initTimers(){
     // init time in minutes
-    timeWhite = QTime(0, time, 0);
-    timeBlack = QTime(0, time, 0);
-
-    rTimeBlack = 0;
-    rTimeBlack = 0;
-    whiteCounter = 1000;
-    blackCounter = 1000;
+    clockWhite.reset(time * 60000);
+    clockBlack.reset(time * 60000);
     if(whiteTimer) delete whiteTimer;
     if(blackTimer) delete blackTimer;
     whiteTimer = new QTimer(this);
     blackTimer = new QTimer(this);
 
-    ui->whiteCountDown->setText(timeWhite.toString("m:ss"));
-    ui->blackCountDown->setText(timeBlack.toString("m:ss"));
+    ui->whiteCountDown->setText(countdownText(clockWhite.remaining()));
+    ui->blackCountDown->setText(countdownText(clockBlack.remaining()));
     connect(whiteTimer, SIGNAL(timeout()), this, SLOT(updateCountdown()));
     connect(blackTimer, SIGNAL(timeout()), this, SLOT(updateCountdown()));
 }
 
 void BoardDialog::startTimer(bool restart){
     if(restart) initTimers();
+    // the labels only show seconds, they are refreshed often enough to catch the end of the time
     if(gameState.getCurrentPlayer() == Color::WHITE){
-        if(restart or rTimeWhite == 0) whiteTimer->start(1);
-        else whiteTimer->start(rTimeWhite);
+        clockWhite.start();
+        whiteTimer->start(50);
     }
     else{
-        if(restart or rTimeBlack == 0) blackTimer->start(1);
-        else blackTimer->start(rTimeBlack);
+        clockBlack.start();
+        blackTimer->start(50);
     }
 }
 
 void BoardDialog::stopTimer(){
     if(gameState.getCurrentPlayer() == Color::WHITE){
-        if(whiteTimer){
-            rTimeWhite = whiteTimer->remainingTime();
-            whiteTimer->stop();
-        }
+        clockWhite.stop();
+        if(whiteTimer) whiteTimer->stop();
     }
-    else if(blackTimer){
-        rTimeBlack = blackTimer->remainingTime();
-        blackTimer->stop();
+    else{
+        clockBlack.stop();
+        if(blackTimer) blackTimer->stop();
     }
 }
 
 void BoardDialog::switchTimers(){
     // stop timer of previous player
     if(gameState.getCurrentPlayer() == Color::BLACK){
-        rTimeWhite = whiteTimer->remainingTime();
+        clockWhite.stop();
         whiteTimer->stop();
     }
     else{
-        rTimeBlack = blackTimer->remainingTime();
+        clockBlack.stop();
         blackTimer->stop();
     }
     startTimer(false);
@@ -234,6 +231,8 @@ void BoardDialog::freezeControlPanel(const Color winner){
     }
     ui->description->setText(description);
     canvas->active = false;
+    clockWhite.stop();
+    clockBlack.stop();
     whiteTimer->stop();
     blackTimer->stop();
     ui->description->repaint();
@@ -243,33 +242,18 @@ void BoardDialog::freezeControlPanel(const Color winner){
 
 void BoardDialog::updateCountdown()
 {
-    /*
-     * Timers are updated in every 1 millisec but only the seconds are shown on the UI
-     * This way the bot has sub-sec resolution and can better schedule the time for each step
-    */
+    // the bots read the clocks directly, the labels are only for the player
     if(currPlayer == Color::WHITE){
-        timeWhite = timeWhite.addMSecs(-1);
-        --whiteCounter;
-        if(whiteCounter == 0){
-            ui->whiteCountDown->setText(timeWhite.toString("m:ss"));
-            whiteCounter = 1000;
-        }
-        if(timeWhite.toString("m:ss:z") == "0:00:0"){
+        long int msecs = clockWhite.remaining();
+        ui->whiteCountDown->setText(countdownText(msecs));
+        if(msecs <= 0)
             freezeControlPanel(Color::BLACK);
-        }
-        else whiteTimer->start(1);
     }
     else{
-        timeBlack = timeBlack.addMSecs(-1);
-        --blackCounter;
-        if(blackCounter == 0){
-            ui->blackCountDown->setText(timeBlack.toString("m:ss"));
-            blackCounter = 1000;
-        }
-        if(timeBlack.toString("m:ss:z") == "0:00:0"){
+        long int msecs = clockBlack.remaining();
+        ui->blackCountDown->setText(countdownText(msecs));
+        if(msecs <= 0)
             freezeControlPanel(Color::WHITE);
-        }
-        else blackTimer->start(1);
     }
 }
 
@@ -8,6 +8,7 @@
 #include <QTime>
 
 #include "canvas.h"
+#include "gameclock.h"
 #include "gamestate.h"
 #include "aibotbase.h"
 #include "randombot.h"
@@ -72,14 +73,11 @@ private:
 
     // ---- timers ----
     unsigned int time;
-    unsigned int rTimeWhite;
-    unsigned int rTimeBlack;
+    // the clocks hold the time of the players, the timers only refresh the countdown labels
     QTimer* whiteTimer;
     QTimer* blackTimer;
-    unsigned int whiteCounter;
-    unsigned int blackCounter;
-    QTime timeWhite;
-    QTime timeBlack;
+    GameClock clockWhite;
+    GameClock clockBlack;
     Color currPlayer;
 
 signals:
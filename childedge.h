@@ -0,0 +1,16 @@
+#ifndef CHILDEDGE_H
+#define CHILDEDGE_H
+
+struct ChildEdge
+/*
+ * child of a node resolved in the transposition table. The table changes the generation of a handle when it removes
+ * the node, so a stale edge is detected without probing the table again.
+ */
+{
+    unsigned int moveIdx;
+    // 0 if the child is not resolved
+    unsigned int handle;
+    unsigned int generation;
+};
+
+#endif // CHILDEDGE_H
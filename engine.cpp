@@ -0,0 +1,175 @@
+#include "engine.h"
+
+#include <cassert>
+#include <type_traits>
+
+#include "evenscheduler.h"
+#include "hmcravenode.h"
+#include "nodebudgetscheduler.h"
+#include "parallelmcts.h"
+#include "playoutbudgetscheduler.h"
+#include "stopscheduler.h"
+#include "uctnode.h"
+
+#define assertm(exp, msg) assert(((void)msg, exp))
+
+// ---- search construction ----
+
+template<typename NodeType, typename SchedulerType>
+struct Search: public Engine::SearchBase
+{
+    unique_ptr<ZHashTable<NodeType>> tTable;
+    unique_ptr<SchedulerType> scheduler;
+
+    virtual ~Search() override{
+        // the search refers to the table and the scheduler
+        mcts.reset();
+    }
+};
+
+template<typename NodeType, typename SchedulerType>
+static SchedulerType* makeScheduler(const GameClock* timeLeft, GameState* gameState, ZHashTable<NodeType>* tTable,
+                                    const EngineOptions& options)
+{
+    if constexpr(is_same<SchedulerType, EvenScheduler>::value)
+        return new EvenScheduler(timeLeft, gameState);
+    else if constexpr(is_same<SchedulerType, PlayoutBudgetScheduler>::value)
+        return new PlayoutBudgetScheduler(options.searchBudget);
+    else if constexpr(is_same<SchedulerType, NodeBudgetScheduler<NodeType>>::value)
+        return new NodeBudgetScheduler<NodeType>(tTable, options.searchBudget);
+    else
+        return new SchedulerType(timeLeft, gameState, tTable);
+}
+
+template<typename NodeType, typename SchedulerType>
+static Engine::SearchBase* makeSearch(GameState* gameState, const GameClock* timeLeft, MAST* policy,
+                                      BatchRollout* rollouts, const EngineOptions& options)
+{
+    typedef MCTS<NodeType, MAST, SchedulerType> SerialType;
+    typedef RootParallelMCTS<NodeType, MAST, SchedulerType> RootParallelType;
+    typedef TreeParallelMCTS<NodeType, MAST, SchedulerType> TreeParallelType;
+    auto search = new Search<NodeType, SchedulerType>();
+    search->tTable = make_unique<ZHashTable<NodeType>>(gameState, policy, 20, options.budget);
+    search->scheduler.reset(makeScheduler<NodeType, SchedulerType>(timeLeft, gameState, search->tTable.get(), options));
+    ZHashTable<NodeType>* tTable = search->tTable.get();
+    SchedulerType* scheduler = search->scheduler.get();
+    if(options.numThreads > 1){
+        // tree parallelization is not supported with node recycling
+        if constexpr(ZHashTable<NodeType>::isRecycledType)
+            search->mcts.reset(new RootParallelType(tTable, gameState, policy, scheduler, options.numThreads));
+        else if(options.rootParallel)
+            search->mcts.reset(new RootParallelType(tTable, gameState, policy, scheduler, options.numThreads));
+        else
+            search->mcts.reset(new TreeParallelType(tTable, gameState, policy, scheduler, options.numThreads));
+    }
+    else
+        search->mcts.reset(new SerialType(tTable, gameState, policy, scheduler, rollouts));
+    return search;
+}
+
+template<typename NodeType>
+static Engine::SearchBase* makeSearch(GameState* gameState, const GameClock* timeLeft, MAST* policy,
+                                      BatchRollout* rollouts, const EngineOptions& options)
+{
+    if(options.scheduler == "even")
+        return makeSearch<NodeType, EvenScheduler>(gameState, timeLeft, policy, rollouts, options);
+    if(options.scheduler == "playouts")
+        return makeSearch<NodeType, PlayoutBudgetScheduler>(gameState, timeLeft, policy, rollouts, options);
+    if(options.scheduler == "nodes")
+        return makeSearch<NodeType, NodeBudgetScheduler<NodeType>>(gameState, timeLeft, policy, rollouts, options);
+    assertm(options.scheduler == "stop", "Invalid scheduler");
+    return makeSearch<NodeType, StopScheduler<NodeType>>(gameState, timeLeft, policy, rollouts, options);
+}
+
+Engine::Engine(GameState* gameState, const GameClock* timeLeft, const EngineOptions& options):
+    gameState{gameState},
+    searchState{make_unique<GameState>(*gameState)},
+    policy{make_unique<MAST>(searchState.get())},
+    ponder{options.ponder},
+    stopPonder{false},
+    numPonderPlayouts{0},
+    lastPonderPlayouts{0}
+{
+    if(options.batchRollouts)
+        rollouts = make_unique<BatchRollout>(searchState.get());
+    if(options.recycling){
+        if(options.node == "UCT-2")
+            search.reset(makeSearch<RecyclingNode<UCTNode>>(searchState.get(), timeLeft, policy.get(), rollouts.get(), options));
+        else if(options.node == "MCRAVE")
+            search.reset(makeSearch<RecyclingNode<RAVENode>>(searchState.get(), timeLeft, policy.get(), rollouts.get(), options));
+        else
+            assertm(false, "Invalid node type");
+    }
+    else{
+        if(options.node == "UCT-2")
+            search.reset(makeSearch<UCTNode>(searchState.get(), timeLeft, policy.get(), rollouts.get(), options));
+        else if(options.node == "MCRAVE")
+            search.reset(makeSearch<RAVENode>(searchState.get(), timeLeft, policy.get(), rollouts.get(), options));
+        else
+            assertm(false, "Invalid node type");
+    }
+}
+
+Engine::~Engine()
+{
+    stopPondering();
+    // the search uses the policy and the rollouts
+    search.reset();
+}
+
+// ---- game flow ----
+
+void Engine::setup(){
+    stopPondering();
+    // gameState is expected to be reset
+    searchState->reset();
+    // wasteful but marginal
+    search->mcts->reset();
+}
+
+void Engine::reset(){
+    stopPondering();
+    // gameState is expected to be reset
+    searchState->reset();
+    search->mcts->reset();
+    numPonderPlayouts = lastPonderPlayouts = 0;
+}
+
+void Engine::update(unsigned int moveIdx){
+    // the subtree of the move becomes the root, the pondering goes on from there until the turn of the engine
+    stopPondering();
+    searchState->update(moveIdx);
+    search->mcts->updateRoot(moveIdx);
+    startPondering();
+}
+
+void Engine::selectBestMoves(){
+    stopPondering();
+    lastPonderPlayouts = numPonderPlayouts;
+    numPonderPlayouts = 0;
+    unsigned int numTakenMoves = searchState->numTakenMoves();
+    search->mcts->run();
+    for(unsigned int i = numTakenMoves; i < searchState->numTakenMoves(); ++i)
+        gameState->update(searchState->takenMove(i));
+    startPondering();
+}
+
+unsigned long int Engine::ponderedPlayouts() const{
+    return lastPonderPlayouts;
+}
+
+// ---- pondering ----
+
+void Engine::startPondering(){
+    if(!ponder or searchState->end())
+        return;
+    stopPonder.store(false, memory_order_relaxed);
+    ponderThread = thread([this]{ numPonderPlayouts += search->mcts->ponder(stopPonder); });
+}
+
+void Engine::stopPondering(){
+    if(!ponderThread.joinable())
+        return;
+    stopPonder.store(true, memory_order_relaxed);
+    ponderThread.join();
+}
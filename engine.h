@@ -0,0 +1,87 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "batchrollout.h"
+#include "gameclock.h"
+#include "gamestate.h"
+#include "mast.h"
+#include "mcts.h"
+
+using namespace std;
+
+struct EngineOptions{
+    // "UCT-2" or "MCRAVE"
+    string node = "UCT-2";
+    bool recycling = false;
+    // maximum number of nodes with recycling
+    unsigned int budget = 50000;
+    unsigned int numThreads = 1;
+    bool rootParallel = false;
+    // "stop" (parabolic time distribution with early termination), "even" (same time for every move), "playouts" or
+    // "nodes" (searchBudget playouts or stored nodes per search whatever the time left)
+    string scheduler = "stop";
+    unsigned long int searchBudget = 10000;
+    // leaves are evaluated by batched random playouts, only with a single thread. The moves of the batch give no AMAF
+    // update, MCRAVE loses the AMAF values of the playouts
+    bool batchRollouts = false;
+    // the search goes on in the background during the turn of the opponent, on a single thread
+    bool ponder = false;
+};
+
+class Engine
+/*
+ * MCTS player without Qt: it builds the search of the node type from the options and owns the policy, the
+ * transposition table and the scheduler. The game state is shared with the caller who updates it with the moves of
+ * the opponent, the engine plays its own moves on it. The GUI bots and the command line interface both drive it.
+ * The search runs on a copy of the game state, so that with pondering it can go on while the caller reads or updates
+ * the shared state. A move of the opponent stops pondering and the subtree of the move is kept as the new root.
+ */
+{
+public:
+    Engine(GameState* gameState, const GameClock* timeLeft, const EngineOptions& options);
+    ~Engine();
+    Engine(const Engine&)=delete;
+    Engine& operator=(const Engine&)=delete;
+
+    // computes the initial policy before the first game
+    void setup();
+    // gameState is expected to be reset
+    void reset();
+    // gameState is expected to be updated with moveIdx
+    void update(unsigned int moveIdx);
+    // plays the moves of the current player on gameState
+    void selectBestMoves();
+    // playouts of the pondering before the last selectBestMoves(), they are kept in the tree of the search
+    unsigned long int ponderedPlayouts() const;
+
+    // owns the search together with the table and the scheduler of its node type
+    struct SearchBase{
+        virtual ~SearchBase()=default;
+        unique_ptr<MCTSBase> mcts;
+    };
+
+private:
+    // background search from the current position until stopPondering()
+    void startPondering();
+    void stopPondering();
+
+    GameState* gameState;
+    // position of the search, the shared state is only written by selectBestMoves()
+    unique_ptr<GameState> searchState;
+    unique_ptr<MAST> policy;
+    unique_ptr<BatchRollout> rollouts;
+    unique_ptr<SearchBase> search;
+    const bool ponder;
+    thread ponderThread;
+    atomic<bool> stopPonder;
+    // only read while pondering is stopped
+    unsigned long int numPonderPlayouts;
+    unsigned long int lastPonderPlayouts;
+};
+
+#endif // ENGINE_H
@@ -0,0 +1,127 @@
+#ifndef GAMECLOCK_H
+#define GAMECLOCK_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+struct TimeControl{
+    long int mainMsecs = 0;
+    // added to the main time after each move played in main time (Fischer), not during byo-yomi
+    long int incrementMsecs = 0;
+    // byo-yomi after the main time: a move may use one period for free, each period it overruns is lost
+    long int periodMsecs = 0;
+    unsigned int numPeriods = 0;
+};
+
+class GameClock
+/*
+ * time left of a player, the clock runs while the player is on move. The game controller starts and stops it and
+ * the search reads it from its own thread, so the state is guarded by a mutex. The time is kept in microseconds of
+ * std::chrono::steady_clock, the engine does not need Qt. Once the main time is over the byo-yomi periods are used,
+ * the player loses on time when a move overruns the last period.
+ */
+{
+public:
+    explicit GameClock(long int msecs=0){
+        reset(msecs);
+    }
+
+    GameClock(const GameClock&)=delete;
+    GameClock& operator=(const GameClock&)=delete;
+
+    // stopped with msecs of main time and no increment or byo-yomi
+    void reset(long int msecs){
+        TimeControl control;
+        control.mainMsecs = msecs;
+        reset(control);
+    }
+
+    void reset(const TimeControl& control){
+        std::lock_guard<std::mutex> lock(mutex);
+        this->control = control;
+        mainMicros = control.mainMsecs * 1000;
+        numPeriods = control.numPeriods;
+        flagged = false;
+        running = false;
+    }
+
+    void start(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(running or flagged)
+            return;
+        startTime = std::chrono::steady_clock::now();
+        running = true;
+    }
+
+    // the move is over, the increment is added if it ended in main time, otherwise the periods it overran are lost
+    void stop(){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!running)
+            return;
+        running = false;
+        int64_t used = elapsed();
+        if(used <= mainMicros){
+            mainMicros += control.incrementMsecs * 1000 - used;
+            return;
+        }
+        // byo-yomi, the main time stays empty
+        int64_t over = used - mainMicros;
+        int64_t period = control.periodMsecs * 1000;
+        mainMicros = 0;
+        if(period == 0 or over > numPeriods * period){
+            numPeriods = 0;
+            flagged = true;
+            return;
+        }
+        numPeriods -= (over - 1) / period;
+    }
+
+    // milliseconds until the player loses on time if the clock keeps running, negative once the time is over
+    long int remaining() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        if(flagged)
+            return -1;
+        int64_t left = mainMicros + numPeriods * control.periodMsecs * 1000 - (running ? elapsed() : 0);
+        return left >= 0 ? left / 1000 : -1 + left / 1000;
+    }
+
+    // milliseconds of main time left
+    long int mainRemaining() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        int64_t left = mainMicros - (running ? elapsed() : 0);
+        return left > 0 ? left / 1000 : 0;
+    }
+
+    // milliseconds of byo-yomi the current move may use without losing a period, 0 without periods left
+    long int periodRemaining() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        return numPeriods > 0 ? control.periodMsecs : 0;
+    }
+
+    // milliseconds added after a move that ends in main time
+    long int increment() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        return control.incrementMsecs;
+    }
+
+    bool isRunning() const{
+        std::lock_guard<std::mutex> lock(mutex);
+        return running;
+    }
+
+private:
+    int64_t elapsed() const{
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    mutable std::mutex mutex;
+    TimeControl control;
+    int64_t mainMicros;
+    unsigned int numPeriods;
+    bool flagged;
+    bool running;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+#endif // GAMECLOCK_H
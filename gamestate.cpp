@@ -1,38 +1,52 @@
 #include "gamestate.h"
+#include "allocaudit.h"
 #include <algorithm>
+#include <memory>
+#include <thread>
 
 // ---- (re-)initializations ----
 
 GameState::GameState(int boardSize, FeatureFlags flags):
     boardSize{boardSize},
     flags{flags},
-    bitmapSize{sizeof(long int)*8},
+    rng{Rng::StateStream},
     currentColor{WHITE},
-    playerScores{{{WHITE,0}, {BLACK,0}}},
     cellNum{computeCellNum(boardSize)},
-    validMoves{cellNum},
+    validMoves{cellNum, rng},
     currentPlayer{WHITE},
-    previousPlayer{WHITE}
+    groups{cellNum},
+    playerScores{cellNum}
 {
     // each player should have equal moves so we divide by 4
     numSteps = cellNum - cellNum%4;
-    // we need as much bits to be able to represent each cell on the board
-    freeNeighbourBitMapSize = (cellNum+bitmapSize-1)/bitmapSize;
+    moveIdxs.reserve(cellNum);
+    moveStamps.reserve(cellNum);
+    numUpdates = 0;
+    moveUnions.reserve(cellNum);
     initCells();
 }
 
+GameState::GameState(const GameState& other):
+    GameState(other.boardSize, other.flags)
+{
+    for(unsigned int moveIdx : other.moveIdxs)
+        update(moveIdx);
+}
+
 void GameState::reset(){
     currentColor = WHITE;
     moveIdxs.clear();
+    moveStamps.clear();
     currentPlayer = WHITE;
-    playerScores = {{WHITE,0}, {BLACK,0}};
+    playerScores.clear();
     numSteps = cellNum - cellNum%4;
     // cellVec has pointers but it does not have ownership so we only call clear()
     cells.clear();
     cellVec.clear();
-    validMoves = ValidMoves{cellNum};
+    validMoves = ValidMoves{cellNum, rng};
     initCells();
-    groups.clear();
+    groups = UnionFind{cellNum};
+    moveUnions.clear();
 }
 
 inline bool GameState::isValidAx(const Ax& ax)
@@ -112,24 +126,22 @@ void GameState::initCells(){
 // ---- forward updates ----
 
 void GameState::update(unsigned int moveIdx){
+    ALLOC_AUDIT_SCOPE(StateUpdate);
     moveIdxs.push_back(moveIdx);
+    moveStamps.push_back(++numUpdates);
     unsigned int cellIdx = lastTakenCellIdx();
     validMoves.remove(cellIdx);
     Cell& cell = idxToCell(cellIdx);
     cell.color = currentColor;
     mergeGroups(cell);
-    //updateNeighbourBitMaps(cell);
     --numSteps;
     updateColors();
 }
 
 void GameState::updateColors(){
-    if(currentColor == WHITE){
+    if(currentColor == WHITE)
         currentColor = BLACK;
-        previousPlayer = previousPlayer == WHITE? BLACK : WHITE;
-    }
     else{
-        previousPlayer = currentPlayer;
         currentPlayer = currentPlayer == WHITE? BLACK : WHITE;
         currentColor = WHITE;
     }
@@ -138,139 +150,37 @@ void GameState::updateColors(){
 void GameState::mergeGroups(Cell& cell)
 {
     Color color = cell.color;
-    unsigned int newGroupSize=1;
-
-    //the array of neighbour super groups
-    list<unsigned int> addedNeighbourSuperGroupIds;
-    if(groups[color].size()>0){
-        addedNeighbourSuperGroupIds = cell.getNeighbourGroupIds(groups[color], color);
-    }
-    else{
-        playerScores[color] = 1;
-        goto singleGroup;
-    }
-
-    //If there is no neighbour of the same color
-    if(addedNeighbourSuperGroupIds.size()==0)
-    {
-        singleGroup:
-        // create a new group with size 1
-        unsigned int groupId = groups[color].size();
-        cell.groupId = groupId;
-        groups[color].push_back({groupId, newGroupSize});
-        return;
-    }
-
-    // the first is going to be the new supergroup id
-    unsigned int moveGroupId = addedNeighbourSuperGroupIds.front();
-
-    //update the groupnum of the cell
-    cell.groupId = moveGroupId;
-
-    // update neighbour groups and compute new group size
-    for(unsigned int nGroupId: addedNeighbourSuperGroupIds)
-    {
-        Group& neighbourGroup = groups[color][nGroupId];
-        // add the size of the groups to the size of the new group
-        newGroupSize += neighbourGroup.size;
-        playerScores[color] /= neighbourGroup.size;
-
-        // update neighbour group with new super group id
-        neighbourGroup.id = moveGroupId;
-    }
-    // we only store the other groups
-    addedNeighbourSuperGroupIds.pop_front();
-
-    // add the list of group numbers of other groups'
-    Group& group = groups[color][moveGroupId];
-    group.addedGroupIds[color].push(std::move(addedNeighbourSuperGroupIds));
-
-    group.size = newGroupSize;
-    //update the new groupsize and add the addedgroups
-    playerScores[color] *= newGroupSize;
-}
-
-void GameState::updateNeighbourBitMaps(Cell& cell)
-{
-    // get color, group, idx of the piece that has been placed
-    unsigned int groupId = cell.groupId;
-    Color color = cell.color;
-    Color oppColor = color == WHITE?BLACK:WHITE;
-    unsigned int idx = cell.idx;
-    Group& group = groups[color][groupId];
-
-    // the index of the long value
-    unsigned int bitMapIdx=idx/bitmapSize;
-    // the bit position in the long value
-    unsigned int bitPos=idx-bitMapIdx*bitmapSize;
-
-    // init neighbourmap of the group
-    group.freeNeighbourBitMaps.push(vector<long int>(freeNeighbourBitMapSize));
-
-    if(group.size > 1){
-        //merge the bitmaps of the old groups to the new
-        mergeNeighbourBitMaps(cell);
-    }
-
-    //remove the field of the move from the map as it is taken
-    group.freeNeighbourBitMaps.top()[bitMapIdx]&=~(1<<bitPos);
-
-    list<unsigned int> oppNGroupIds = cell.getNeighbourGroupIds(groups[oppColor], oppColor);
-
-    // we keep the values for backward update
-    group.addedGroupIds[oppColor].push(oppNGroupIds);
-    if(oppNGroupIds.size() > 0){
-        // set the bit index of the move to zero in groups of the opposite color
-        for(unsigned int oppNeighbourGroupId : group.addedGroupIds[oppColor].top())
-            groups[oppColor][oppNeighbourGroupId].freeNeighbourBitMaps.top()[bitMapIdx]&=~(1<<bitPos);
-    }
-
-    //add the free neighbours around the cell
-    // iterate over the neighbours
-    for(const Cell* nCell : cell.neighbours)
-    {
-        if(nCell->color==EMPTY)
-        {
-            bitMapIdx=nCell->idx/bitmapSize;
-            bitPos=nCell->idx-bitMapIdx*bitmapSize;
-            group.freeNeighbourBitMaps.top()[bitMapIdx]|=(1<<bitPos);
-        }
-    }
-}
-
-void GameState::mergeNeighbourBitMaps(Cell& cell)
-{
-    unsigned int groupId = cell.groupId;
-    Color color = cell.color;
-    Group& group = groups[color][groupId];
-    unsigned int i;
-    // we check each connected group neighbour map and use bitwise or (bit value 1 means free neighbour)
-    for(unsigned int nGroupId : group.addedGroupIds[color].top())
-    {
-        // iterate over the long values of the map
-        i = 0;
-        for(const auto& bMap : groups[color][nGroupId].freeNeighbourBitMaps.top()){
-            // bitwise or
-            group.freeNeighbourBitMaps.top()[i] |= bMap;
-            ++i;
-        }
+    unsigned int numUnions = groups.numUnions();
+    unsigned int root = cell.idx;
+    for(const Cell* nCell : cell.neighbours){
+        if(nCell->color != color)
+            continue;
+        unsigned int nRoot = groups.find(nCell->idx);
+        // the neighbour is already connected through another neighbour
+        if(nRoot == root)
+            continue;
+        playerScores.remove(color, groups.size(nRoot));
+        root = groups.unite(root, nRoot);
     }
+    playerScores.add(color, groups.size(root));
+    moveUnions.push_back(groups.numUnions() - numUnions);
 }
 
 // ---- backward updates ----
 
 void GameState::undo()
 {
+    ALLOC_AUDIT_SCOPE(StateUndo);
     // we expect that the caller do not call when there is no taken cells
     Cell& cell = idxToCell(lastTakenCellIdx());
 
-    // undoOppBitMaps(cell);
     decomposeGroup(cell);
     ++numSteps;
     undoColors();
 
     validMoves.undo();
     moveIdxs.pop_back();
+    moveStamps.pop_back();
 }
 
 void GameState::undoColors(){
@@ -286,59 +196,27 @@ void GameState::decomposeGroup(Cell& cell)
 {
     Color color = cell.color;
     cell.color = EMPTY;
-    Color oppColor = color == WHITE?BLACK:WHITE;
-    unsigned int groupId = cell.groupId;
-    Group& group = groups[color][groupId];
+    unsigned int numUnions = moveUnions.back();
+    moveUnions.pop_back();
 
-    // no connection, just remove the group
-    if(group.size==1)
-    {
-        groups[color].pop_back();
+    playerScores.remove(color, groups.size(groups.find(cell.idx)));
+    // no connection, the stone was a group alone
+    if(numUnions == 0)
         return;
-    }
-    playerScores[color] /= group.size;
-
-    //decrease the size with the removed field
-    --group.size;
-
-    // group was already existing, we remove the last bitmap
-    // group.freeNeighbourBitMaps.pop();
-
-    // restore component groups
-    for(unsigned int cGroupId : group.addedGroupIds[color].top()){
-        Group& component = groups[color][cGroupId];
-        playerScores[color] *= component.size;
-        group.size -= component.size;
-        component.id = cGroupId;
-    }
-
-    // group was already existing multiply back with the original size
-    playerScores[color] *= group.size;
-
-    group.addedGroupIds[color].pop();
-    // group.addedGroupIds[oppColor].pop();
-}
-
-void GameState::undoOppBitMaps(const Cell& cell)
-{
-    // get color, group, idx of the piece has been placed
-    unsigned int groupId = cell.groupId;
-    Color color = cell.color;
-    Color oppColor = color == WHITE?BLACK:WHITE;
-    unsigned int idx = cell.idx;
-
-    Group& group = groups[color][groupId];
-
-    // the index of the long value
-    unsigned int bitMapIdx=idx/bitmapSize;
-    // the bit position in the long value
-    unsigned int bitPos=idx-bitMapIdx*bitmapSize;
-
-    //set the bit of the move on the map of each group of the opposite color
-    for(unsigned int oppNeighbourGroupId : group.addedGroupIds[oppColor].top())
-    {
-        Group& oppGroup = groups[oppColor][oppNeighbourGroupId];
-        oppGroup.freeNeighbourBitMaps.top()[bitMapIdx]|=(1<<bitPos);
+    for(; numUnions > 0; --numUnions)
+        groups.undo();
+
+    // restore the neighbour groups, there are maximum 3 distinct groups
+    unsigned int nRoots[3];
+    unsigned int numGroups = 0;
+    for(const Cell* nCell : cell.neighbours){
+        if(nCell->color != color)
+            continue;
+        unsigned int nRoot = groups.find(nCell->idx);
+        if(std::find(nRoots, nRoots + numGroups, nRoot) == nRoots + numGroups){
+            nRoots[numGroups++] = nRoot;
+            playerScores.add(color, groups.size(nRoot));
+        }
     }
 }
 
@@ -369,9 +247,10 @@ inline unsigned int GameState::axToIdx(Ax ax) const{
 // ---- queries ----
 
 Color GameState::leader(){
-    if(playerScores[Color::WHITE] > playerScores[Color::BLACK])
+    int order = playerScores.compare();
+    if(order > 0)
         return Color::WHITE;
-    else if(playerScores[Color::WHITE] < playerScores[Color::BLACK])
+    else if(order < 0)
         return BLACK;
     return EMPTY;
 }
@@ -384,30 +263,50 @@ bool GameState::end() const{
     return numSteps == 0;
 }
 
-map<Color, int> GameState::getPlayerScores() const{
-    return playerScores;
+map<Color, double> GameState::getPlayerScores() const{
+    return {{WHITE, playerScores.score(WHITE)}, {BLACK, playerScores.score(BLACK)}};
 }
 
 double GameState::getScore(){
-    if(playerScores[Color::WHITE] > playerScores[Color::BLACK])
+    int order = playerScores.compare();
+    if(order > 0)
         return 1.0;
-    else if(playerScores[Color::WHITE] < playerScores[Color::BLACK])
+    else if(order < 0)
         return 0.0;
     return 0.5;
 }
 
+int GameState::getBoardSize() const{
+    return boardSize;
+}
+
 Color GameState::getCurrentPlayer() const{
     return currentPlayer;
 }
 
 Color GameState::getPreviousPlayer() const{
-    return previousPlayer;
+    // the player who placed the last piece, a turn is two pieces. It is not stored so undo() does not have to restore it
+    if(moveIdxs.empty())
+        return WHITE;
+    return (moveIdxs.size()-1)/2%2 == 0? WHITE : BLACK;
 }
 
 unsigned int GameState::takenMove() const{
     return moveIdxs.back();
 }
 
+unsigned int GameState::numTakenMoves() const{
+    return moveIdxs.size();
+}
+
+unsigned int GameState::takenMove(unsigned int i) const{
+    return moveIdxs[i];
+}
+
+unsigned long int GameState::moveStamp(unsigned int i) const{
+    return moveStamps[i];
+}
+
 unsigned int GameState::numExpectedMoves() const{
     return (numSteps + 2) / 4;
 }
@@ -446,36 +345,89 @@ unsigned int GameState::lastTakenCellIdx() const{
     return moveIdxs.back()%cellNum;
 }
 
-array<vector<double>, 2> GameState::getInitialPolicy(){
+Color GameState::cellColor(unsigned int cellIdx) const{
+    return cellVec[cellIdx]->color;
+}
+
+unsigned int GameState::groupSize(unsigned int cellIdx) const{
+    if(cellVec[cellIdx]->color == EMPTY)
+        return 0;
+    return groups.size(groups.find(cellIdx));
+}
+
+vector<unsigned int> GameState::neighbourIdxs(unsigned int cellIdx) const{
+    vector<unsigned int> idxs;
+    for(const Cell* nCell : cellVec[cellIdx]->neighbours)
+        idxs.push_back(nCell->idx);
+    return idxs;
+}
+
+unsigned int GameState::numRemainingMoves() const{
+    return numSteps;
+}
+
+array<vector<double>, 2> GameState::getInitialPolicy(uint64_t seed, unsigned int numThreads){
     // compute initial policy by simulating n random playouts and averaging the results based on the outcome
-    unsigned int n = 50000;
-    array<vector<double>, 2> scores = {vector<double>(cellNum*2, 0.5), vector<double>(cellNum*2, 0.5)};
-    vector<double> counts = vector<double>(cellNum*2, 1.0);
+    unsigned int n = numPriorPlayouts;
+    if(numThreads == 0)
+        numThreads = max(thread::hardware_concurrency(), 1u);
+    numThreads = min(numThreads, numPriorStreams);
+    // stream i of the seed plays the i-th share of the playouts, the workers take the streams in turn on their own copy
+    vector<vector<double>> outcomes(numPriorStreams, vector<double>(cellNum*2, 0.0));
+    vector<vector<double>> counts(numPriorStreams, vector<double>(cellNum*2, 0.0));
+    auto work = [&](GameState* worker, unsigned int first){
+        for(unsigned int i = first; i < numPriorStreams; i += numThreads){
+            worker->rng = Rng{seed, i};
+            unsigned int numPlayouts = n / numPriorStreams + (i < n % numPriorStreams);
+            worker->playRandomGames(numPlayouts, outcomes[i], counts[i]);
+        }
+    };
+    vector<unique_ptr<GameState>> workers;
+    for(unsigned int i = 0; i < numThreads; ++i)
+        workers.push_back(make_unique<GameState>(*this));
+    vector<thread> threads;
+    threads.reserve(numThreads);
+    for(unsigned int i = 0; i < numThreads; ++i)
+        threads.emplace_back(work, workers[i].get(), i);
+    for(auto& t : threads)
+        t.join();
+    // each score starts from 0.5 with the weight of one playout, the streams are merged in order so the sums are
+    // reproducible for a given seed
+    array<vector<double>, 2> scores = {vector<double>(cellNum*2), vector<double>(cellNum*2)};
+    for(unsigned int moveIdx = 0; moveIdx < cellNum*2; ++moveIdx){
+        double outcome = 0.5;
+        double count = 1.0;
+        for(unsigned int i = 0; i < numPriorStreams; ++i){
+            outcome += outcomes[i][moveIdx];
+            count += counts[i][moveIdx];
+        }
+        scores[WHITE][moveIdx] = outcome / count;
+        scores[BLACK][moveIdx] = (count - outcome) / count;
+    }
+    return scores;
+}
+
+void GameState::playRandomGames(unsigned int n, vector<double>& outcomes, vector<double>& counts){
     vector<unsigned int> cellIdxs;
-    cellIdxs.reserve(cellNum*2);
-    for(int idx = 0; idx < cellNum; ++idx)
-        cellIdxs.push_back(idx);
+    cellIdxs.reserve(cellNum);
+    for(unsigned int moveIdx : validMoves)
+        cellIdxs.push_back(moveIdx % cellNum);
+    unsigned int startMove = moveIdxs.size();
     for(unsigned int i = 0; i < n; ++i){
-        random_shuffle(cellIdxs.begin(), cellIdxs.end());
+        shuffle(cellIdxs.begin(), cellIdxs.end(), rng);
         unsigned int idx = 0;
-        vector<unsigned int> rMoveIdxs;
-        rMoveIdxs.reserve(cellNum);
         while(numSteps > 0){
-            rMoveIdxs.push_back(cellIdxs[idx] + cellNum * currentColor);
-            update(rMoveIdxs[idx]);
+            update(cellIdxs[idx] + cellNum * currentColor);
             ++idx;
         }
         double outcome = getScore();
-        auto it = rMoveIdxs.crbegin();
-        while(it != rMoveIdxs.crend()){
+        while(moveIdxs.size() > startMove){
+            unsigned int moveIdx = takenMove();
             undo();
-            scores[WHITE][*it] = (scores[WHITE][*it] * counts[*it] + outcome) / (counts[*it]+1);
-            scores[BLACK][*it] = (scores[BLACK][*it] * counts[*it] + 1 - outcome) / (counts[*it]+1);
-            ++counts[*it];
-            ++it;
+            outcomes[moveIdx] += outcome;
+            ++counts[moveIdx];
         }
     }
-    return scores;
 }
 
 // ---- operators ----
@@ -492,17 +444,18 @@ GameState::ValidMoves::FreeCell::FreeCell(unsigned int idx):
     next{nullptr}
 {}
 
-GameState::ValidMoves::ValidMoves(unsigned int cellNum):
+GameState::ValidMoves::ValidMoves(unsigned int cellNum, Rng& rng):
     cellNum{cellNum},
     color{0}
 {
     mSize = cellNum;
     freeCells.reserve(cellNum);
     lookup.reserve(cellNum);
+    takenCells.reserve(cellNum);
     for(unsigned int i=0; i<cellNum; ++i)
         freeCells.push_back({i});
     // produce random order
-    random_shuffle(freeCells.begin(), freeCells.end());
+    shuffle(freeCells.begin(), freeCells.end(), rng);
     for(unsigned int idx=0; idx<cellNum; ++idx){
         for(unsigned int i=0; i<cellNum; ++i){
             if(freeCells[i].idx == idx)
@@ -530,7 +483,7 @@ void GameState::ValidMoves::remove(unsigned int idx){
     // if it is not the last item we set the next item
     if(lookup[idx]->next)
         lookup[idx]->next->prev = lookup[idx]->prev;
-    takenCells.push(idx);
+    takenCells.push_back(idx);
     --mSize;
 }
 
@@ -540,9 +493,9 @@ unsigned int GameState::ValidMoves::getRandomMove() const {
 
 void GameState::ValidMoves::undo(){
     color = color == 1 ? 0 : 1;
-    unsigned int prev = takenCells.top();
+    unsigned int prev = takenCells.back();
     // remove from taken cells
-    takenCells.pop();
+    takenCells.pop_back();
     // if there is no free cells
     if(!first){
         first = lookup[prev];
@@ -568,6 +521,6 @@ unsigned int GameState::ValidMoves::size() const{
 }
 
 unsigned int GameState::ValidMoves::prevCellIdx() const{
-    return takenCells.top();
+    return takenCells.back();
 }
 
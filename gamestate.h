@@ -7,6 +7,9 @@
 #include <array>
 
 #include "cell.h"
+#include "groupscores.h"
+#include "rng.h"
+#include "unionfind.h"
 
 struct Ax{
     int q, r;
@@ -23,6 +26,9 @@ public:
         Separators = 2,
     };
     GameState(int boardSize, FeatureFlags flags);
+    // cells and valid moves keep raw pointers into their own containers so the moves are replayed on a fresh board
+    GameState(const GameState& other);
+    GameState& operator=(const GameState&)=delete;
 
     // ---- inline functions for both external and internal usage ----
     inline bool isFlagSet(FeatureFlags flag) const{
@@ -35,6 +41,7 @@ public:
 
     // cellNum should be declared before freeCells!
     const unsigned int cellNum;
+    int getBoardSize() const;
     Color getCurrentPlayer() const;
     Color getPreviousPlayer() const;
     Color getCurrentColor() const;
@@ -43,8 +50,13 @@ public:
     double getScore();
     void update(unsigned int moveIdx);
     void undo();
-    map<Color, int> getPlayerScores() const;
+    // the scores are rounded when they do not fit into a double
+    map<Color, double> getPlayerScores() const;
     unsigned int takenMove() const;
+    // moves taken from the empty board, the stamp of a move is unique so a move taken again after an undo differs
+    unsigned int numTakenMoves() const;
+    unsigned int takenMove(unsigned int i) const;
+    unsigned long int moveStamp(unsigned int i) const;
     unsigned int numExpectedMoves() const;
     unsigned int getRandomMove() const;
     unsigned int getWhiteCell() const;
@@ -52,7 +64,19 @@ public:
     unsigned int moveNum() const;
     unsigned int toMoveIdx(unsigned int cellIdx, unsigned int pieceIdx) const;
     unsigned int lastTakenCellIdx() const;
-    array<vector<double>, 2> getInitialPolicy();
+    Color cellColor(unsigned int cellIdx) const;
+    // stones in the group of the cell, 0 for an empty cell
+    unsigned int groupSize(unsigned int cellIdx) const;
+    // indices of the neighbour cells in clockwise order
+    vector<unsigned int> neighbourIdxs(unsigned int cellIdx) const;
+    // pieces left to place until the end of the game
+    unsigned int numRemainingMoves() const;
+    // number of random playouts of the initial policy, split into a fixed number of streams of the seed
+    static constexpr unsigned int numPriorPlayouts = 50000;
+    static constexpr unsigned int numPriorStreams = 64;
+    // averaged outcomes of random playouts per move, computed by numThreads workers (0 uses every core). The result
+    // only depends on the seed, not on the number of workers
+    array<vector<double>, 2> getInitialPolicy(uint64_t seed, unsigned int numThreads=0);
 
 private:
     // ---- available moves ----
@@ -60,7 +84,8 @@ private:
     {
         // container class for storing the available cells
     public:
-        ValidMoves(unsigned int cellNum);
+        // the cells are iterated in a random order
+        ValidMoves(unsigned int cellNum, Rng& rng);
         unsigned int prevCellIdx() const;
         void remove(unsigned int cellIdx);
         unsigned int getRandomMove() const;
@@ -105,7 +130,7 @@ private:
         // lookup for instant accessing items from freeCells
         vector<FreeCell*> lookup;
         FreeCell* first;
-        stack<unsigned int> takenCells;
+        vector<unsigned int> takenCells;
         unsigned int mSize;
         unsigned int cellNum;
         unsigned int color;
@@ -118,13 +143,14 @@ private:
     // ---- forward update ----
     void mergeGroups(Cell& cell);
     void updateColors();
-    void updateNeighbourBitMaps(Cell& cell);
-    void mergeNeighbourBitMaps(Cell& cell);
 
     // ---- backward update ----
     void decomposeGroup(Cell& cell);
     void undoColors();
-    void undoOppBitMaps(const Cell& cell);
+
+    // ---- initial policy ----
+    // outcome sums and counts per move of n random playouts from the current state, the state is restored
+    void playRandomGames(unsigned int n, vector<double>& outcomes, vector<double>& counts);
 
     // ---- bit manipulations ----
     unsigned int popCnt64(uint64_t i);
@@ -138,21 +164,25 @@ private:
     // ---- variables ----
 
     FeatureFlags flags;
+    // declared before validMoves which is shuffled with it
+    Rng rng;
     unsigned int numSteps;
-    unsigned int freeNeighbourBitMapSize;
     const int boardSize;
     vector<vector<Cell>> cells;
     vector<Cell*> cellVec;
 
-    map<Color, int> playerScores;
-    size_t bitmapSize;
     Color currentColor;
     Color currentPlayer;
-    Color previousPlayer;
-    list<unsigned int> moveIdxs;
+    // reserved for every cell so moves do not allocate
+    vector<unsigned int> moveIdxs;
+    vector<unsigned long int> moveStamps;
+    unsigned long int numUpdates;
+    // groups of stones of both colors, the number of unions of each move is kept to undo them
+    UnionFind groups;
+    vector<unsigned int> moveUnions;
+    GroupScores playerScores;
 public:
     ValidMoves validMoves;
-    map<Color, vector<Group>> groups;
 };
 
 #endif // GAMESTATE_H
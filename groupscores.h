@@ -0,0 +1,114 @@
+#ifndef GROUPSCORES_H
+#define GROUPSCORES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "cell.h"
+
+class GroupScores
+/*
+ * scores of the players, the product of the group sizes of their color. The products overflow any integer type on
+ * large boards so the sum of the logarithms is kept instead, with the number of groups of each size. The logarithms
+ * are fixed point integers, the sums are exact and do not drift over millions of updates and undos. add() and remove()
+ * are O(1). Players are compared by the log sums, the exact products are only computed from the group counts when the
+ * difference is within the rounding error of the table.
+ */
+{
+public:
+    explicit GroupScores(unsigned int cellNum):
+        logs(cellNum+1),
+        counts{vector<unsigned int>(cellNum+1, 0), vector<unsigned int>(cellNum+1, 0)},
+        logSums{0, 0},
+        numGroups{0, 0},
+        products{vector<uint32_t>(cellNum/32+2), vector<uint32_t>(cellNum/32+2)}
+    {
+        for(unsigned int size = 1; size <= cellNum; ++size)
+            logs[size] = std::llround(std::log(static_cast<double>(size)) * scale);
+    }
+
+    void clear(){
+        for(unsigned int color = 0; color < 2; ++color){
+            std::fill(counts[color].begin(), counts[color].end(), 0);
+            logSums[color] = 0;
+            numGroups[color] = 0;
+        }
+    }
+
+    // a group of the color with size stones is created
+    inline void add(Color color, unsigned int size){
+        ++counts[color][size];
+        logSums[color] += logs[size];
+        ++numGroups[color];
+    }
+
+    // a group of the color with size stones is removed or merged into another
+    inline void remove(Color color, unsigned int size){
+        --counts[color][size];
+        logSums[color] -= logs[size];
+        --numGroups[color];
+    }
+
+    // 1 if white has the larger score, -1 if black, 0 on a tie
+    int compare() const{
+        // a color without stones scores 0, otherwise at least 1
+        if(numGroups[WHITE] == 0 or numGroups[BLACK] == 0)
+            return (numGroups[WHITE] > 0) - (numGroups[BLACK] > 0);
+        int64_t diff = logSums[WHITE] - logSums[BLACK];
+        // each logarithm in the sums is rounded by at most half a unit
+        int64_t maxError = numGroups[WHITE] + numGroups[BLACK];
+        if(diff > maxError)
+            return 1;
+        if(diff < -maxError)
+            return -1;
+        return compareExact();
+    }
+
+    // the score of the color, rounded when it does not fit into a double
+    double score(Color color) const{
+        if(numGroups[color] == 0)
+            return 0;
+        return std::round(std::exp(logSums[color] / scale));
+    }
+
+private:
+    // fixed point unit of the logarithms
+    static constexpr double scale = 1099511627776.0; // 2^40
+
+    int compareExact() const{
+        for(unsigned int color = 0; color < 2; ++color){
+            // little endian base 2^32 digits
+            vector<uint32_t>& product = products[color];
+            std::fill(product.begin(), product.end(), 0);
+            product[0] = 1;
+            for(unsigned int size = 2; size < counts[color].size(); ++size){
+                for(unsigned int i = 0; i < counts[color][size]; ++i){
+                    uint64_t carry = 0;
+                    for(uint32_t& digit : product){
+                        uint64_t value = static_cast<uint64_t>(digit) * size + carry;
+                        digit = static_cast<uint32_t>(value);
+                        carry = value >> 32;
+                    }
+                }
+            }
+        }
+        for(unsigned int i = products[WHITE].size(); i-- > 0;){
+            if(products[WHITE][i] != products[BLACK][i])
+                return products[WHITE][i] > products[BLACK][i] ? 1 : -1;
+        }
+        return 0;
+    }
+
+    // logs[size] = log(size) * scale
+    vector<int64_t> logs;
+    // counts[color][size] is the number of groups of the color with size stones
+    vector<unsigned int> counts[2];
+    int64_t logSums[2];
+    unsigned int numGroups[2];
+    // buffers of the exact comparison, a product of group sizes has less bits than the number of cells
+    mutable vector<uint32_t> products[2];
+};
+
+#endif // GROUPSCORES_H
@@ -2,9 +2,14 @@
 #define RAVENode_H
 
 #include "recyclingnode.h"
+#include "relaxed.h"
 #include "zhashtable.h"
 #include "mast.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <list>
 
 class RAVENode
@@ -15,8 +20,9 @@ class RAVENode
     friend class Node<RAVENode>;
 
 public:
+    // the AMAF values are copied by the table
     RAVENode(const RAVENode&)=default;
-    RAVENode& operator=(const RAVENode&)=default;
+    RAVENode& operator=(const RAVENode&)=delete;
 
     template<typename T=RAVENode>
     inline T* select();
@@ -27,11 +33,20 @@ public:
     template<typename T=RAVENode>
     inline T* expand();
 
-    inline void updateLeaf(unsigned int moveIdx, unsigned int childIdx){}
+    // the simulated move is not counted as a visit of the leaf
+    template<typename T=RAVENode>
+    inline void updateLeaf(unsigned int){}
+
+    inline void addVirtualLoss();
+    inline void removeVirtualLoss();
 
     template<typename T=RAVENode>
     inline void backward();
 
+    // a move of the playout taken back on another state than the one of the search, player placed the piece
+    template<typename T=RAVENode>
+    inline void collect(Color player, Color piece, unsigned int moveIdx);
+
     template<typename T=RAVENode>
     inline void backprop(double outcome);
 
@@ -41,90 +56,160 @@ public:
     template<typename T=RAVENode>
     inline void manageMemory();
 
-    template<typename T=RAVENode>
-    inline double actionScore(RAVENode* child, unsigned int moveIdx, Color playerColor) const;
-
     inline double stateScore() const;
     inline double visitCount() const;
 
+    // bytes of child edges and AMAF values stored after the node
+    static constexpr size_t extraSize(unsigned int numChild){
+        return numChild * (sizeof(ChildEdge) + sizeof(AMAF));
+    }
+    inline size_t extraSize() const;
+
+    // children in the order of the valid moves when the node was created, the table allocates them right after the
+    // node of type T
+    template<typename T=RAVENode>
+    inline ChildEdge* edges();
+    inline unsigned int childNum() const;
+
     const unsigned long int key;
     const unsigned int depth;
 
+    struct SearchData{
+        // moves to update during backpropagation: playercolor-piececolor-moveidx
+        array<array<list<unsigned int>, 2>, 2> takenMoves;
+        // position of the moves among the child edges of the updated node, noChild for the other moves
+        vector<unsigned int> childIdxs;
+    };
+
+    static constexpr unsigned int noChild = numeric_limits<unsigned int>::max();
+
 protected:
     template<typename T=RAVENode>
     RAVENode(unsigned long int key, const T* =nullptr);
 
     virtual ~RAVENode()=default;
 
-    template<typename T=RAVENode>
-    static void setup(MAST* policy, GameState* gameState, ZHashTable<T>* tTable);
+    struct AMAF{
+        // mean in 32 bit fixed point, a zero count means the value is not seeded from the policy yet. An update
+        // changes the mean by less than the resolution only when it is within count/2^32 of the sample
+        uint32_t mean;
+        uint32_t count;
+        static constexpr double scale = UINT32_MAX;
+        inline double value() const{
+            return mean / scale;
+        }
+        inline void seed(double prior){
+            mean = llround(clamp(prior, 0.0, 1.0) * scale);
+            count = 1;
+        }
+        inline void update(double val){
+            mean = llround(clamp(value() + (val - value()) / (count + 1.0), 0.0, 1.0) * scale);
+            // the weight of new samples stops decreasing when the count saturates
+            if(count < UINT32_MAX)
+                ++count;
+        }
+    };
 
-    inline static void reset();
+    // AMAF values of the children, after the child edges
+    template<typename T>
+    inline AMAF* amafValues();
+    template<typename T>
+    inline const AMAF* amafValues() const;
 
     inline void updateMC(double val);
-    inline void updateRAVE(double val, Color player, Color piece);
+    template<typename T>
+    inline void updateRAVE(double val, const list<unsigned int>& moves);
 
     // k value for weigthing MC and AMAF values
     static constexpr double k = 500;
 
-    // MC values are stored at the child nodes so they get more samples
-    double mcMean;
-    double mcCount;
+    // MC values are stored at the child nodes so they get more samples, the selection of the parents reads them
+    Relaxed<double> mcMean;
+    Relaxed<double> mcCount;
+    // number of unfinished descents through the node, counted as lost playouts until backpropagation
+    Relaxed<unsigned int> vLoss;
 
-    // AMAF values are stored at the parent, we could use a vector but that might need a lot more memory (should be the length of all possible moves)
-    vector<double> rMean;
-    vector<double> rCount;
-    // moves to update during backpropagation: playercolor-piececolor-moveidx
-    inline static array<array<list<unsigned int>, 2>, 2> takenMoves;
+    // AMAF values are stored at the parent, only for the valid moves of the node (the moves of the current color)
+    unsigned int numChild;
 };
 
 template<typename T>
 RAVENode::RAVENode(unsigned long int key, const T*):
     key{key},
-    depth{Node<T>::currDepth},
-    mcCount{1}
+    depth{Node<T>::context->currDepth},
+    mcCount{1},
+    vLoss{0}
 {
-    mcMean = depth > 0 ? Node<T>::policy->getScore(Node<T>::gameState->takenMove(), Node<T>::gameState->getPreviousPlayer()) : 0.5;
-    // assign initial values from the default policy (heuristical assignment)
-    rMean = Node<T>::policy->getScores(Node<T>::gameState->getCurrentPlayer());
-    // confidence is given by the number of equivalent samples
-    rCount = vector<double>(rMean.size(), 1);
+    SearchContext<T>* ctx = Node<T>::context;
+    mcMean = depth > 0 ? ctx->policy->getScore(ctx->gameState->takenMove(), ctx->gameState->getPreviousPlayer()) : 0.5;
+    numChild = ctx->gameState->validMoves.size();
+    // children are resolved when they are first selected
+    ChildEdge* edge = edges<T>();
+    for(unsigned int moveIdx : ctx->gameState->validMoves)
+        *edge++ = {moveIdx, 0, 0};
+    // initial values are assigned from the default policy (heuristical assignment) when they are first used
+    fill_n(amafValues<T>(), numChild, AMAF{0, 0});
 }
 
 template<typename T>
-void RAVENode::setup(MAST* policy, GameState* gameState, ZHashTable<T>* tTable)
-{
-    Node<T>::setup(policy, gameState, tTable);
-    RAVENode::takenMoves = {};
+RAVENode::AMAF* RAVENode::amafValues(){
+    return reinterpret_cast<AMAF*>(edges<T>() + numChild);
 }
 
-void RAVENode::reset(){
-    RAVENode::takenMoves = {};
+template<typename T>
+const RAVENode::AMAF* RAVENode::amafValues() const{
+    return reinterpret_cast<const AMAF*>(reinterpret_cast<const char*>(this) + sizeof(T) + numChild * sizeof(ChildEdge));
+}
+
+template<typename T>
+ChildEdge* RAVENode::edges(){
+    return reinterpret_cast<ChildEdge*>(reinterpret_cast<char*>(this) + sizeof(T));
+}
+
+unsigned int RAVENode::childNum() const{
+    return numChild;
+}
+
+size_t RAVENode::extraSize() const{
+    return RAVENode::extraSize(numChild);
 }
 
 template<typename T>
 T* RAVENode::select(){
-    double maxScore = -1;
-    double score;
-    unsigned int bestMoveIdx;
-    T* bestChild;
-    Color playerColor = Node<T>::gameState->getCurrentPlayer();
-    for(unsigned int moveIdx : Node<T>::gameState->validMoves){
-        Node<T>::tTable->update(moveIdx);
-        T* child = Node<T>::tTable->load();
-        score = actionScore<T>(child, moveIdx, playerColor);
-        if(score > maxScore){
-            maxScore = score;
-            bestChild = child;
-            bestMoveIdx = moveIdx;
+    SearchContext<T>* ctx = Node<T>::context;
+    SelectBuffers<T>& children = ctx->children;
+    children.reserve(numChild);
+    ChildEdge* edge = edges<T>();
+    AMAF* amaf = amafValues<T>();
+    Color playerColor = ctx->gameState->getCurrentPlayer();
+    // gather the child values, unexplored children get the score of the default policy
+    for(unsigned int idx = 0; idx < numChild; ++idx){
+        unsigned int moveIdx = edge[idx].moveIdx;
+        if(!amaf[idx].count)
+            amaf[idx].seed(ctx->policy->getScore(moveIdx, playerColor));
+        T* child = Node<T>::child(edge[idx]);
+        children.nodes[idx] = child;
+        if(child){
+            // unfinished descents through the child are weighted as lost playouts. Each statistic is read once, another
+            // worker could be updating them
+            double mcCount = child->mcCount;
+            unsigned int pending = child->vLoss;
+            double count = mcCount + pending;
+            children.counts[idx] = count;
+            children.means[idx] = pending ? child->mcMean * mcCount / count : child->mcMean;
         }
-        // xor twice with the same value gives back the original
-        Node<T>::tTable->update(moveIdx);
+        else{
+            children.counts[idx] = 0;
+            children.means[idx] = ctx->policy->getScore(moveIdx, playerColor);
+        }
+        children.amaf[idx] = amaf[idx].value();
     }
+    unsigned int bestIdx = argmaxRAVE(children.means.data(), children.counts.data(), children.amaf.data(), numChild, RAVENode::k);
     // visit the node
-    Node<T>::gameState->update(bestMoveIdx);
-    Node<T>::tTable->update(bestMoveIdx);
-    return bestChild;
+    unsigned int bestMoveIdx = edge[bestIdx].moveIdx;
+    ctx->gameState->update(bestMoveIdx);
+    ctx->tTable->update(bestMoveIdx);
+    return children.nodes[bestIdx];
 }
 
 void RAVENode::updateMC(double val){
@@ -133,36 +218,68 @@ void RAVENode::updateMC(double val){
     ++mcCount;
 }
 
-void RAVENode::updateRAVE(double val, Color player, Color piece){
-    for(unsigned int moveIdx : RAVENode::takenMoves[player][piece]){
-        rMean[moveIdx] = (rMean[moveIdx] * rCount[moveIdx]+val)/(rCount[moveIdx]+1);
-        ++rCount[moveIdx];
+template<typename T>
+void RAVENode::updateRAVE(double val, const list<unsigned int>& moves){
+    if(moves.empty())
+        return;
+    // the moves were played later on the cells that are free at the node
+    SearchContext<T>* ctx = Node<T>::context;
+    vector<unsigned int>& childIdxs = ctx->data.childIdxs;
+    childIdxs.resize(ctx->gameState->moveNum(), noChild);
+    ChildEdge* edge = edges<T>();
+    for(unsigned int idx = 0; idx < numChild; ++idx)
+        childIdxs[edge[idx].moveIdx] = idx;
+    AMAF* amaf = amafValues<T>();
+    Color player = ctx->gameState->getCurrentPlayer();
+    for(unsigned int moveIdx : moves){
+        unsigned int childIdx = childIdxs[moveIdx];
+        // a move that is not a child of the node has no AMAF value
+        if(childIdx == noChild)
+            continue;
+        AMAF& value = amaf[childIdx];
+        if(!value.count)
+            value.seed(ctx->policy->getScore(moveIdx, player));
+        value.update(val);
     }
+    // the next node starts from the sentinel
+    for(unsigned int idx = 0; idx < numChild; ++idx)
+        childIdxs[edge[idx].moveIdx] = noChild;
 }
 
 template<typename T>
 void RAVENode::backprop(double outcome){
-    Color player = Node<T>::gameState->getCurrentPlayer();
-    Color piece = Node<T>::gameState->getCurrentColor();
+    SearchContext<T>* ctx = Node<T>::context;
+    auto& takenMoves = ctx->data.takenMoves;
+    Color player = ctx->gameState->getCurrentPlayer();
+    Color piece = ctx->gameState->getCurrentColor();
     // action value is updated with the current player
-    updateRAVE(outcome+player*(1.0-2.0*outcome), player, piece);
-    unsigned int moveIdx = Node<T>::gameState->takenMove();
-    Node<T>::gameState->undo();
+    updateRAVE<T>(outcome+player*(1.0-2.0*outcome), takenMoves[player][piece]);
+    unsigned int moveIdx = ctx->gameState->takenMove();
+    ctx->gameState->undo();
     // state value is updated with parent player
-    player = Node<T>::gameState->getCurrentPlayer();
+    player = ctx->gameState->getCurrentPlayer();
     updateMC(outcome+player*(1.0-2.0*outcome));
-    piece = Node<T>::gameState->getCurrentColor();
-    RAVENode::takenMoves[player][piece].push_back(moveIdx);
-    Node<T>::tTable->update(moveIdx);
+    piece = ctx->gameState->getCurrentColor();
+    takenMoves[player][piece].push_back(moveIdx);
+    ctx->tTable->update(moveIdx);
 }
 
 template<typename T>
 void RAVENode::backpropRoot(double outcome){
-    Color player = Node<T>::gameState->getCurrentPlayer();
-    Color piece = Node<T>::gameState->getCurrentColor();
+    SearchContext<T>* ctx = Node<T>::context;
+    Color player = ctx->gameState->getCurrentPlayer();
+    Color piece = ctx->gameState->getCurrentColor();
     // action value is updated with the current player
-    updateRAVE(outcome+player*(1.0-2.0*outcome), player, piece);
-    RAVENode::takenMoves = {};
+    updateRAVE<T>(outcome+player*(1.0-2.0*outcome), ctx->data.takenMoves[player][piece]);
+    ctx->data.takenMoves = {};
+}
+
+void RAVENode::addVirtualLoss(){
+    ++vLoss;
+}
+
+void RAVENode::removeVirtualLoss(){
+    --vLoss;
 }
 
 double RAVENode::stateScore() const {
@@ -174,26 +291,23 @@ double RAVENode::visitCount() const {
 }
 
 template<typename T>
-double RAVENode::actionScore(RAVENode* child, unsigned int moveIdx, Color playerColor) const {
-    double beta = sqrt(RAVENode::k / ((child ? child->mcCount : 0) + RAVENode::k));
-    double score = (1-beta) * (child ? child->mcMean : Node<T>::policy->getScore(moveIdx, playerColor)) + beta * (rMean[moveIdx]);
-    return score;
+void RAVENode::backward(){
+    SearchContext<T>* ctx = Node<T>::context;
+    unsigned int moveIdx = ctx->gameState->takenMove();
+    ctx->gameState->undo();
+    // player is the one who played the move
+    collect<T>(ctx->gameState->getCurrentPlayer(), ctx->gameState->getCurrentColor(), moveIdx);
+    ctx->tTable->update(moveIdx);
 }
 
 template<typename T>
-void RAVENode::backward(){
-    unsigned int moveIdx = Node<T>::gameState->takenMove();
-    Node<T>::gameState->undo();
-    // player is the one who played the move
-    Color player = Node<T>::gameState->getCurrentPlayer();
-    Color piece = Node<T>::gameState->getCurrentColor();
-    RAVENode::takenMoves[player][piece].push_back(moveIdx);
-    Node<T>::tTable->update(moveIdx);
+void RAVENode::collect(Color player, Color piece, unsigned int moveIdx){
+    Node<T>::context->data.takenMoves[player][piece].push_back(moveIdx);
 }
 
 template<typename T>
 T* RAVENode::selectMostVisited(){
-    return Node<T>::selectMostVisited();
+    return Node<T>::selectMostVisited(static_cast<T*>(this));
 }
 
 template<typename T>
@@ -5,32 +5,66 @@ MAST::MAST(GameState* gameState, double temp, double w):
     gameState{gameState},
     temp{temp},
     w{w},
-    moves{{}}
+    moves{{}},
+    rng{Rng::PolicyStream}
 {
     scores = {vector<double>(gameState->moveNum(), 1.0), vector<double>(gameState->moveNum(), 1.0)};
+    initWeights();
+}
+
+MAST::MAST(MAST& other, GameState* gameState, unsigned int stream):
+    scores{other.scores},
+    prior{other.prior},
+    moves{},
+    w{other.w},
+    temp{other.temp},
+    gameState{gameState},
+    rng{other.rng(), stream}
+{
+    initWeights();
 }
 
 void MAST::setup(){
-    if(initialScores[WHITE].size() == 0 or initialScores[BLACK].size() == 0)
-        initialScores = gameState->getInitialPolicy();
-    scores = initialScores;
-}
-
-tuple<unsigned int, unsigned int> MAST::select() const{
-    default_random_engine generator;
-    Color currPlayer = gameState->getCurrentPlayer();
-    list<int> probs;
-    vector<unsigned int> idxMap;
-    idxMap.reserve(gameState->validMoves.size());
-    for(unsigned int moveIdx : gameState->validMoves){
-        idxMap.push_back(moveIdx);
-        // no normalization is needed, relative volume matters
-        probs.push_back(exp(scores[currPlayer][moveIdx]/temp) + 1e-8);
+    if(!prior or prior->moveNum() != gameState->moveNum())
+        prior = PriorCache::load(gameState);
+    for(Color player : {WHITE, BLACK})
+        scores[player].assign(prior->scores(player), prior->scores(player) + prior->moveNum());
+    initWeights();
+}
+
+unsigned int MAST::select(){
+    return select(gameState);
+}
+
+void MAST::initWeights(){
+    unsigned int cellNum = gameState->cellNum;
+    for(auto& playerTrees : trees)
+        playerTrees = {SumTree(cellNum), SumTree(cellNum)};
+    taken.assign(cellNum, false);
+    takenMoves.clear();
+    syncedState = gameState;
+    takenMoves.reserve(cellNum);
+    for(Color player : {WHITE, BLACK}){
+        weights[player].resize(gameState->moveNum());
+        for(unsigned int moveIdx = 0; moveIdx < gameState->moveNum(); ++moveIdx)
+            setWeight(player, moveIdx);
     }
+}
+
+void MAST::setWeight(Color player, unsigned int moveIdx){
+    unsigned int cellNum = gameState->cellNum;
+    weights[player][moveIdx] = exp(scores[player][moveIdx]/temp) + 1e-8;
+    if(!taken[moveIdx % cellNum])
+        trees[player][moveIdx / cellNum].set(moveIdx % cellNum, weights[player][moveIdx]);
+}
 
-    discrete_distribution<> distribution (probs.begin(), probs.end());
-    unsigned int idx = distribution(generator);
-    return {idxMap[idx], idx};
+void MAST::setTaken(unsigned int cellIdx, bool isTaken){
+    unsigned int cellNum = gameState->cellNum;
+    taken[cellIdx] = isTaken;
+    for(Color player : {WHITE, BLACK}){
+        for(unsigned int color = 0; color < 2; ++color)
+            trees[player][color].set(cellIdx, isTaken ? 0 : weights[player][cellIdx + color * cellNum]);
+    }
 }
 
 void MAST::addMove(Color player, unsigned int moveIdx){
@@ -43,10 +77,15 @@ void MAST::update(double outcome){
         double val = outcome + move.player * (1.0-2.0*outcome);
         // update moving average
         scores[move.player][move.moveIdx] = w * scores[move.player][move.moveIdx] + (1 - w) * val;
+        setWeight(move.player, move.moveIdx);
     }
     moves.clear();
 }
 
+void MAST::discard(){
+    moves.clear();
+}
+
 vector<double> MAST::getScores(Color playerColor) const{
     return scores[playerColor];
 }
@@ -1,13 +1,16 @@
 #ifndef MAST_H
 #define MAST_H
 
+#include "allocaudit.h"
 #include "gamestate.h"
+#include "priorcache.h"
+#include "rng.h"
+#include "sumtree.h"
 
-#include <random>
 #include <vector>
 #include <array>
 #include <list>
-#include <tuple>
+#include <memory>
 
 class MAST
 {
@@ -15,9 +18,18 @@ public:
     MAST(GameState* gameState, double temp=5, double w=0.98);
     ~MAST()=default;
     MAST(const MAST&)=delete;
+    // copy of the learnt scores driving another game state (e.g. for a search thread). The generator of the copy is
+    // seeded by a draw of the source, each copy of the same search should have its own stream number
+    MAST(MAST& other, GameState* gameState, unsigned int stream);
     MAST& operator=(const MAST&)=delete;
-     tuple<unsigned int, unsigned int> select() const;
+    // move drawn with probability proportional to exp(score/temp) among the valid moves
+    unsigned int select();
+    // the same draw on another state with the interface of GameState, e.g. the bitboard the rollouts are played on
+    template<typename StateType>
+    unsigned int select(const StateType* state);
     void update(double outcome);
+    // forgets the moves of a playout that is not backpropagated
+    void discard();
     void addMove(Color player, unsigned int moveIdx);
     void reset();
     void setup();
@@ -33,11 +45,68 @@ protected:
     };
     array<vector<double>, 2> scores;
 
-    array<vector<double>, 2> initialScores;
+    // shared by the copies of the policy
+    shared_ptr<const PriorCache> prior;
     list<Move> moves;
     double w;
     double temp;
     GameState* gameState;
+
+    // ---- sampling ----
+    struct TakenMove{
+        unsigned long int stamp;
+        unsigned int cellIdx;
+    };
+    // follows the moves taken or undone on the state since the last draw
+    template<typename StateType>
+    void sync(const StateType* state);
+    // all weights from the scores with every cell free
+    void initWeights();
+    void setWeight(Color player, unsigned int moveIdx);
+    void setTaken(unsigned int cellIdx, bool isTaken);
+
+    // weights[player][moveIdx] = exp(score/temp)
+    array<vector<double>, 2> weights;
+    // trees[player][color] over the cells, taken cells have 0 weight
+    array<array<SumTree, 2>, 2> trees;
+    vector<bool> taken;
+    // the moves of syncedState the trees are synchronized with, the stamps of two states are not comparable
+    vector<TakenMove> takenMoves;
+    const void* syncedState;
+    Rng rng;
 };
 
+template<typename StateType>
+unsigned int MAST::select(const StateType* state){
+    ALLOC_AUDIT_SCOPE(PolicySelect);
+    sync(state);
+    Color color = state->getCurrentColor();
+    const SumTree& tree = trees[state->getCurrentPlayer()][color];
+    // no normalization is needed, relative volume matters
+    return tree.find(rng.uniform() * tree.total()) + state->cellNum * color;
+}
+
+template<typename StateType>
+void MAST::sync(const StateType* state){
+    if(state != syncedState){
+        while(!takenMoves.empty()){
+            setTaken(takenMoves.back().cellIdx, false);
+            takenMoves.pop_back();
+        }
+        syncedState = state;
+    }
+    unsigned int numTaken = state->numTakenMoves();
+    // undone moves, a different stamp at the same position means that the move was undone and another one was taken
+    while(takenMoves.size() > numTaken or (!takenMoves.empty() and takenMoves.back().stamp != state->moveStamp(takenMoves.size()-1))){
+        setTaken(takenMoves.back().cellIdx, false);
+        takenMoves.pop_back();
+    }
+    while(takenMoves.size() < numTaken){
+        unsigned int i = takenMoves.size();
+        unsigned int cellIdx = state->takenMove(i) % state->cellNum;
+        takenMoves.push_back({state->moveStamp(i), cellIdx});
+        setTaken(cellIdx, true);
+    }
+}
+
 #endif // MAST_H
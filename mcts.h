@@ -1,7 +1,12 @@
 #ifndef MCTS_H
 #define MCTS_H
 
+#include <atomic>
+#include <memory>
 #include <stack>
+#include "allocaudit.h"
+#include "batchrollout.h"
+#include "bitgamestate.h"
 #include "node.h"
 #include "stopscheduler.h"
 
@@ -13,6 +18,8 @@ public:
     virtual void reset()=0;
     virtual void run()=0;
     virtual void updateRoot(unsigned int moveIdx)=0;
+    // searches from the root until stop is raised without playing a move, returns the number of playouts
+    virtual unsigned long int ponder(const atomic<bool>& stop)=0;
 
 };
 
@@ -20,75 +27,135 @@ template<typename NodeType, typename PolicyType=MAST, typename SchedulerType=Sto
 class MCTS: public MCTSBase
 {
 public:
-    MCTS(ZHashTable<NodeType>* tTable, GameState* gameState, PolicyType* policy, SchedulerType* scheduler):
+    // with rollouts, a new leaf is evaluated by a batch of random playouts instead of a single policy playout
+    MCTS(ZHashTable<NodeType>* tTable, GameState* gameState, PolicyType* policy, SchedulerType* scheduler,
+         BatchRollout* rollouts=nullptr):
         tTable{tTable},
         root{tTable->root},
         currNode{root},
         gameState{gameState},
         policy{policy},
         scheduler{scheduler},
-        path{}
-    {}
+        rollouts{rollouts},
+        path{},
+        ponderStop{nullptr}
+    {
+        setupRolloutState();
+    }
 
     virtual ~MCTS()=default;
 
     virtual void reset() override{
+        bind();
         policy->setup();
+        if(rollouts)
+            rollouts->setup();
+        setupRolloutState();
         tTable->reset();
         scheduler->reset();
         this->root = tTable->root;
         path = stack<NodeType*>();
     }
 
-    virtual void updateRoot(unsigned int moveIdx) final{
+    virtual void updateRoot(unsigned int moveIdx) override{
         // gameState is expected to be updated
+        bind();
         root = tTable->updateRoot(moveIdx);
     }
 
     virtual void run() override{
+        bind();
         scheduler->schedule();
+        ALLOC_AUDIT_BEGIN();
+        unsigned long int numPlayouts = 0;
         while(!scheduler->finish()){
             selection();
             double outcome = simulation();
             backpropagation(outcome);
+            numPlayouts += outcome != cutOutcome;
+        }
+        ALLOC_AUDIT_END(numPlayouts);
+        playBestMoves();
+    }
+
+    virtual unsigned long int ponder(const atomic<bool>& stop) override{
+        // the scheduler is not used, its watchdog could still be raised from the last round
+        bind();
+        ponderStop = &stop;
+        unsigned long int numPlayouts = 0;
+        while(!stop.load(memory_order_relaxed)){
+            selection();
+            double outcome = simulation();
+            backpropagation(outcome);
+            numPlayouts += outcome != cutOutcome;
         }
+        ponderStop = nullptr;
+        return numPlayouts;
+    }
+protected:
+    // the node context is thread local, it has to be set on the thread that calls the search
+    void bind(){
+        tTable->bind();
+    }
+
+    // the single policy playouts are played on a bitboard copy of gameState when the board fits into it
+    void setupRolloutState(){
+        int boardSize = gameState->getBoardSize();
+        if(rollouts or boardSize > BitGameState::maxBoardSize)
+            rolloutState = nullptr;
+        else if(!rolloutState or rolloutState->getBoardSize() != boardSize)
+            rolloutState = make_unique<BitGameState>(boardSize);
+    }
+
+    // the playout in progress should stop: the end of the time budget or of the pondering
+    bool aborted() const{
+        return ponderStop ? ponderStop->load(memory_order_relaxed) : scheduler->aborted();
+    }
+
+    void playBestMoves(){
         Color rootPlayer = gameState->getCurrentPlayer();
         do{
             NodeType* bestChild = root->selectMostVisited();
             // with TT it could be that there was only one child explored and removed
-            ++Node<NodeType>::currDepth;
+            ++tTable->context.currDepth;
             if(bestChild)
                 root = bestChild;
             else
                 root = root->expand();
             currPlayer = gameState->getCurrentPlayer();
         }while(rootPlayer == currPlayer);
+        // the pondering goes on from here, the table must not replace the new root as a node above its root
+        root = tTable->advanceRoot();
     }
-protected:
+
     void selection(){
+        ALLOC_AUDIT_SCOPE(Selection);
         currPlayer = gameState->getCurrentPlayer();
         // node selection updates gamestate and TT
         currNode = root;
         NodeType* child = root->select();
-        ++Node<NodeType>::currDepth;
+        ++tTable->context.currDepth;
         policy->addMove(currPlayer, gameState->takenMove());
         while(!gameState->end() and child){
             currNode = child;
             path.push(currNode);
+            currNode->addVirtualLoss();
             currPlayer = gameState->getCurrentPlayer();
             child = currNode->select();
-            ++Node<NodeType>::currDepth;
+            ++tTable->context.currDepth;
             // currPlayer here is the player who placed the last piece
             policy->addMove(currPlayer, gameState->takenMove());
         }
         // expansion, only expand non-terminal node
         if(!gameState->end()){
+            ALLOC_AUDIT_SCOPE(Expansion);
             currNode = currNode->expand();
             path.push(currNode);
+            currNode->addVirtualLoss();
             // move is added during selection
-            auto [moveIdx, childIdx] = policy->select();
+            unsigned int moveIdx = policy->select();
             // depending on the node type we may wish to update the leaf node with the simulated action
-            currNode->updateLeaf(moveIdx, childIdx);
+            currNode->updateLeaf(moveIdx);
             tTable->update(moveIdx);
             currPlayer = gameState->getCurrentPlayer();
             gameState->update(moveIdx);
@@ -97,55 +164,116 @@ protected:
     }
 
     double simulation(){
+        ALLOC_AUDIT_SCOPE(Simulation);
+        // moves played after the leaf
+        unsigned int numMoves = 0;
         double outcome;
-        unsigned int numSim = 1;
+        // gameState stays at the leaf, the bitboard follows it and plays the rest of the game
+        if(rolloutState){
+            rolloutState->follow(*gameState);
+            outcome = playout(rolloutState.get(), numMoves);
+        }
+        else
+            outcome = playout(gameState, numMoves);
+        if(outcome == cutOutcome)
+            policy->discard();
+        else
+            policy->update(outcome);
+        // backward gamestate, transposition table and optionally collect additional data from simulation depending on the type of the node
+        for(; numMoves > 0; --numMoves){
+            if(rolloutState){
+                unsigned int moveIdx = rolloutState->takenMove();
+                rolloutState->undo();
+                tTable->update(moveIdx);
+                // the player who placed the piece
+                root->collect(rolloutState->getCurrentPlayer(), rolloutState->getCurrentColor(), moveIdx);
+            }
+            else
+                // backward operates only on static members but we need an instance for polymorfism
+                root->backward();
+        }
+        // the move of the leaf is on gameState
+        root->backward();
+        return outcome;
+    }
+
+    template<typename StateType>
+    double playout(StateType* state, unsigned int& numMoves){
         while(true){
             // terminal node
-            if(gameState->end()){
+            if(state->end()){
                 // white: 1 black: 0 draw 0.5
-                outcome = gameState->getScore();
-                policy->addMove(currPlayer, gameState->takenMove());
-                break;
+                double outcome = state->getScore();
+                policy->addMove(currPlayer, state->takenMove());
+                return outcome;
             }
             // if the simulated node is in TT, we stop simulation and backprop the stored value
             else if(currNode){
-                outcome = currNode->stateScore();
+                double outcome = currNode->stateScore();
                 // white: score black: 1-score
-                outcome = outcome + currPlayer * (1-2*outcome);
-                break;
+                return outcome + currPlayer * (1-2*outcome);
+            }
+            // the watchdog ended the round or the pondering stops, the cut playout is discarded
+            else if(aborted())
+                return cutOutcome;
+            // the batch plays from the leaf without updating gamestate, only the expanded move is undone. Its moves are
+            // not recorded, so RAVE nodes only get AMAF updates from the moves of the tree
+            else if(rollouts){
+                double outcome = rollouts->run();
+                policy->addMove(currPlayer, state->takenMove());
+                return outcome;
             }
             // keep on simulating
             else{
                 // move is added during selection
-                auto [moveIdx, childIdx] = policy->select();
-                policy->addMove(currPlayer, gameState->takenMove());
-                currPlayer = gameState->getCurrentPlayer();
+                unsigned int moveIdx = policy->select(state);
+                policy->addMove(currPlayer, state->takenMove());
+                currPlayer = state->getCurrentPlayer();
                 tTable->update(moveIdx);
-                gameState->update(moveIdx);
+                state->update(moveIdx);
                 currNode = tTable->load();
-                ++numSim;
+                ++numMoves;
             }
         }
-        policy->update(outcome);
-        // backward gamestate, transposition table and optionally collect additional data from simulation depending on the type of the node
-        while(numSim > 0){
-            // backward operates only on static members but we need an instance for polymorfism
-            root->backward();
-            --numSim;
-        }
-        return outcome;
     }
 
     void backpropagation(double outcome){
+        ALLOC_AUDIT_SCOPE(Backpropagation);
+        if(outcome == cutOutcome){
+            discard();
+            return;
+        }
         while(!path.empty()){
+            path.top()->removeVirtualLoss();
             path.top()->backprop(outcome);
             path.pop();
-            --Node<NodeType>::currDepth;
+            --tTable->context.currDepth;
         }
         root->backpropRoot(outcome);
         root->manageMemory();
     }
 
+    // a cut playout gives back the virtual loss of its path and its moves without updating the statistics. The visit
+    // counts added by the selection stay, the mean of a node is not changed by them
+    void discard(){
+        while(!path.empty()){
+            path.top()->removeVirtualLoss();
+            if constexpr(ZHashTable<NodeType>::isRecycledType)
+                path.top()->requeue();
+            path.top()->backward();
+            path.pop();
+            --tTable->context.currDepth;
+        }
+        if constexpr(ZHashTable<NodeType>::isRecycledType)
+            root->requeue();
+        // the moves collected by backward are not used
+        tTable->context.data = {};
+        root->manageMemory();
+    }
+
+    // outcome of a playout cut by aborted(), it is discarded instead of backpropagated
+    static constexpr double cutOutcome = -1;
+
     Color currPlayer;
     NodeType* root;
     NodeType* currNode;
@@ -153,7 +281,12 @@ protected:
     GameState* gameState;
     PolicyType* policy;
     SchedulerType* scheduler;
+    BatchRollout* rollouts;
+    // copy of gameState the playouts continue on after the leaf, none with batches or on boards too large for it
+    unique_ptr<BitGameState> rolloutState;
     stack<NodeType*> path;
+    // raised by the engine to end the pondering, null during a search
+    const atomic<bool>* ponderStop;
 };
 
 #endif // MCTS_H
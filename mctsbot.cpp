@@ -1,60 +1,37 @@
 #include "mctsbot.h"
-#include <cassert>
-#define assertm(exp, msg) assert(((void)msg, exp))
 
-MCTSBot::MCTSBot(GameState* gameState, const QTime* timeLeft, QString node, bool recycling, unsigned int budget):
-    AiBotBase(gameState, timeLeft)
+static EngineOptions makeOptions(QString node, bool recycling, unsigned int budget, unsigned int numThreads, bool rootParallel,
+                                 bool ponder)
 {
-    policy = new MAST(gameState);
-    if(recycling){
-        if(node == "UCT-2"){
-            auto tTable = new ZHashTable<RecyclingNode<UCTNode>>(gameState, policy, 20, budget);
-            auto scheduler = new StopScheduler<RecyclingNode<UCTNode>>(timeLeft, gameState, tTable);
-            mcts = new MCTS<RecyclingNode<UCTNode>>(tTable, gameState, policy, scheduler);
-        }
-        else if(node == "MCRAVE"){
-            auto tTable = new ZHashTable<RecyclingNode<RAVENode>>(gameState, policy, 20, budget);
-            auto scheduler = new StopScheduler<RecyclingNode<RAVENode>>(timeLeft, gameState, tTable);
-            mcts = new MCTS<RecyclingNode<RAVENode>>(tTable, gameState, policy, scheduler);
-        }
-        else
-            assertm(false, "Invalid node type");
-    }
-    else{
-        if(node == "UCT-2"){
-            auto tTable = new ZHashTable<UCTNode>(gameState, policy, 20);
-            auto scheduler = new StopScheduler<UCTNode>(timeLeft, gameState, tTable);
-            mcts = new MCTS<UCTNode>(tTable, gameState, policy, scheduler);
-        }
-        else if(node == "MCRAVE"){
-            auto tTable = new ZHashTable<RAVENode>(gameState, policy, 20);
-            auto scheduler = new StopScheduler<RAVENode>(timeLeft, gameState, tTable);
-            mcts = new MCTS<RAVENode>(tTable, gameState, policy, scheduler);
-        }
-        else
-            assertm(false, "Invalid node type");
-    }
+    EngineOptions options;
+    options.node = node.toStdString();
+    options.recycling = recycling;
+    options.budget = budget;
+    options.numThreads = numThreads;
+    options.rootParallel = rootParallel;
+    // the bot keeps searching while the player thinks
+    options.ponder = ponder;
+    return options;
 }
 
-MCTSBot::~MCTSBot(){
-    delete mcts;
-    delete policy;
-}
+MCTSBot::MCTSBot(GameState* gameState, const GameClock* timeLeft, QString node, bool recycling, unsigned int budget, unsigned int numThreads, bool rootParallel, bool ponder):
+    AiBotBase(gameState, timeLeft),
+    engine{gameState, timeLeft, makeOptions(node, recycling, budget, numThreads, rootParallel, ponder)}
+{}
 
 void MCTSBot::selectBestMoves(){
-    mcts->run();
+    engine.selectBestMoves();
 }
 
 void MCTSBot::update(unsigned int moveIdx){
-    mcts->updateRoot(moveIdx);
+    engine.update(moveIdx);
 }
 
 void MCTSBot::reset(){
     // gameState is expected to be reset at this point by the GUI
-    mcts->reset();
+    engine.reset();
 }
 
 void MCTSBot::setup(){
-    // wasteful but marginal
-    mcts->reset();
+    engine.setup();
 }
@@ -1,33 +1,23 @@
 #ifndef MCTSBOT_H
 #define MCTSBOT_H
 
-#include <QTime>
-
-
-#include "mast.h"
 #include "aibotbase.h"
-
-#include "stopscheduler.h"
-#include "evenscheduler.h"
-
-#include "hmcravenode.h"
-#include "uctnode.h"
-#include "mcts.h"
+#include "engine.h"
 
 class MCTSBot: public AiBotBase
 {
     Q_OBJECT
 public:
-    MCTSBot(GameState* gameState, const QTime* timeLeft, QString node, bool recycling, unsigned int budget);
-    virtual ~MCTSBot() override;
+    MCTSBot(GameState* gameState, const GameClock* timeLeft, QString node, bool recycling, unsigned int budget, unsigned int numThreads=1, bool rootParallel=false, bool ponder=false);
+    virtual ~MCTSBot() override=default;
     virtual void reset() override;
     virtual void update(unsigned int moveIdx) override;
     virtual void setup() override;
 
 private:
     void selectBestMoves() override;
-    MCTSBase* mcts;
-    MAST* policy;
+    // the search runs on the thread of the bot
+    Engine engine;
 };
 
 #endif // MCTSBOT_H
@@ -8,23 +8,18 @@ class Node;
 template<typename T>
 class StopScheduler;
 
-template<typename T>
-class RecyclingNode;
-
-// type_traits for friend declarations
-template<typename T>
-struct WType{
-    typedef T type;
-};
-
-template<typename T>
-struct WType<RecyclingNode<T>>{
-    typedef T type;
-};
+template<typename X, typename Y, typename Z>
+class TreeParallelMCTS;
 
+#include "childedge.h"
+#include "searchcontext.h"
 #include "mast.h"
 #include "zhashtable.h"
 
+#include <cassert>
+
+#define assertm(exp, msg) assert(((void)msg, exp))
+
 template<typename T>
 class Node
 {
@@ -37,78 +32,95 @@ class Node
     // there is no partial specialization for friend declaration
     template<typename X, typename Y, typename Z>
     friend class MCTS;
+    template<typename X, typename Y, typename Z>
+    friend class TreeParallelMCTS;
 
     // static interface, no instances
     Node()=delete;
     ~Node()=delete;
     Node(const Node&)=delete;
     Node& operator=(const Node&)=delete;
-    static void setup(MAST* policy, GameState* gameState, ZHashTable<T>* tTable);
 
     // mcts updates
-    static T* selectMostVisited();
+    static T* selectMostVisited(T* node);
     static T* expand();
     static void backward();
     static void backprop(double outcome);
 
     static void manageMemory();
 
-    inline static GameState* gameState;
-    inline static ZHashTable<T>* tTable;
-    inline static MAST* policy;
+    // child of the edge, the edge is resolved again if the child was removed from the table
+    static T* child(ChildEdge& edge);
 
-    // node to remove. Deallocation is postponed after backpropagation to avoid deleting a node from the path
-    inline static T* rNode;
-
-    inline static unsigned int currDepth;
+    // context of the search running on this thread, it is bound by the table
+    inline static thread_local SearchContext<T>* context;
 };
 
 template<typename T>
-void Node<T>::setup(MAST* policy, GameState* gameState, ZHashTable<T>* tTable)
-{
-    Node<T>::policy = policy;
-    Node<T>::gameState = gameState;
-    Node<T>::tTable = tTable;
-}
-
-template<typename T>
-T* Node<T>::selectMostVisited(){
+T* Node<T>::selectMostVisited(T* node){
+    SearchContext<T>* ctx = Node<T>::context;
+    // a node of the search is not terminal
+    assertm(node->childNum() > 0, "the node should have a child");
+    ChildEdge* edges = node->template edges<T>();
     double maxVisit = -1;
-    unsigned int bestMoveIdx;
-    T* bestChild;
-    for(unsigned int moveIdx : Node<T>::gameState->validMoves){
-        Node<T>::tTable->update(moveIdx);
-        T* child = Node<T>::tTable->load();
+    unsigned int bestMoveIdx = edges[0].moveIdx;
+    T* bestChild = nullptr;
+    for(unsigned int idx = 0; idx < node->childNum(); ++idx){
+        T* child = Node<T>::child(edges[idx]);
         double visit = child ? child->visitCount() : 0;
         if(visit > maxVisit){
             maxVisit = visit;
             bestChild = child;
-            bestMoveIdx = moveIdx;
+            bestMoveIdx = edges[idx].moveIdx;
         }
-        // xor twice with the same value gives back the original
-        Node<T>::tTable->update(moveIdx);
     }
-    Node<T>::gameState->update(bestMoveIdx);
-    Node<T>::tTable->update(bestMoveIdx);
+    ctx->gameState->update(bestMoveIdx);
+    ctx->tTable->update(bestMoveIdx);
     return bestChild;
 }
 
 template<typename T>
 void Node<T>::backward(){
-    unsigned int moveIdx = Node<T>::gameState->takenMove();
-    Node<T>::gameState->undo();
-    Node<T>::tTable->update(moveIdx);
+    SearchContext<T>* ctx = Node<T>::context;
+    unsigned int moveIdx = ctx->gameState->takenMove();
+    ctx->gameState->undo();
+    ctx->tTable->update(moveIdx);
 }
 
 template<typename T>
 T* Node<T>::expand(){
-    return Node<T>::tTable->store();
+    return Node<T>::context->tTable->store();
+}
+
+template<typename T>
+T* Node<T>::child(ChildEdge& edge){
+    ZHashTable<T>* tTable = Node<T>::context->tTable;
+    if(edge.handle){
+        if(T* child = tTable->resolve(edge))
+            return child;
+    }
+    tTable->update(edge.moveIdx);
+    T* child = tTable->load(edge.handle);
+    if(child){
+        edge.generation = tTable->generation(edge.handle);
+        // with tree parallelization the node could have been removed before the generation was read, it is not found
+        // again then. A removed node is never stored again.
+        if(tTable->load() != child)
+            child = nullptr;
+    }
+    // xor twice with the same value gives back the original
+    tTable->update(edge.moveIdx);
+    if(!child)
+        edge.handle = 0;
+    return child;
 }
 
 template<typename T>
 void Node<T>::manageMemory(){
-    delete Node<T>::rNode;
-    Node<T>::rNode = nullptr;
+    SearchContext<T>* ctx = Node<T>::context;
+    if(ctx->rNode)
+        ctx->tTable->deallocate(ctx->rNode);
+    ctx->rNode = nullptr;
 }
 
 #endif // NODE_H
@@ -0,0 +1,48 @@
+#ifndef NODEBUDGETSCHEDULER_H
+#define NODEBUDGETSCHEDULER_H
+
+#include "zhashtable.h"
+
+template<typename T>
+class NodeBudgetScheduler
+/*
+ * every search stores the same number of nodes in the transposition table, with node recycling a recycled node counts
+ * again. A playout that ends on a terminal node during selection stores nothing: once the tree holds every remaining
+ * position, the search also ends after numNodes such playouts. The game clock is not used.
+ */
+{
+public:
+    NodeBudgetScheduler(ZHashTable<T>* tTable, unsigned long int numNodes):
+        tTable{tTable},
+        numNodes{numNodes},
+        numStores{0},
+        numPlayouts{0}
+    {}
+
+    void schedule(){
+        numStores = tTable->table->numStores;
+        numPlayouts = 0;
+    }
+
+    bool finish(){
+        unsigned long int numStored = tTable->table->numStores - numStores;
+        return numStored >= numNodes or numPlayouts++ >= numStored + numNodes;
+    }
+
+    void reset() {}
+
+    // a playout is never cut short
+    bool aborted() const{
+        return false;
+    }
+
+protected:
+    ZHashTable<T>* tTable;
+    const unsigned long int numNodes;
+    // stores of the table before the search
+    unsigned long int numStores;
+    // number of calls to finish() since the start of the search
+    unsigned long int numPlayouts;
+};
+
+#endif // NODEBUDGETSCHEDULER_H
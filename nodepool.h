@@ -0,0 +1,180 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+
+using namespace std;
+
+template<typename T>
+class NodePool
+/*
+ * typed slab allocator for the nodes of a transposition table. A node can carry extra bytes after the object (e.g. its
+ * child statistics), nodes are grouped into size classes by the number of extra bytes. Memory is requested in slabs of
+ * slabSize nodes per class, released nodes are kept in the free list of their class and clear() makes every slot
+ * available again without giving the slabs back, so a search only reaches the system when the tree grows beyond the
+ * largest tree seen so far.
+ * The slabs are cut from one reserved range of address space whose pages are committed as it grows, so a node is
+ * found from its 32 bit reference (its offset in units of 8 bytes) without a lookup. Each slot starts with a generation
+ * counter that the table changes when it removes the node, it outlives the node.
+ */
+{
+public:
+    NodePool();
+    ~NodePool();
+
+    NodePool(const NodePool&)=delete;
+    NodePool& operator=(const NodePool&)=delete;
+
+    // uninitialized memory for one node followed by extraSize bytes, construct with placement new
+    void* allocate(size_t extraSize=0);
+    // memory of a destructed node, extraSize should be the same as for the allocation
+    void release(void* ptr, size_t extraSize=0);
+    // release every node at once, the nodes have to be destructed beforehand
+    void clear();
+
+    // a reference is never 0
+    inline unsigned int ref(const T* node) const{
+        return (reinterpret_cast<const char*>(node) - arena) / unitSize;
+    }
+    inline T* node(unsigned int ref) const{
+        return reinterpret_cast<T*>(arena + static_cast<size_t>(ref) * unitSize);
+    }
+    inline atomic<unsigned int>& generation(unsigned int ref) const{
+        return *reinterpret_cast<atomic<unsigned int>*>(arena + static_cast<size_t>(ref) * unitSize - headerSize);
+    }
+
+    // number of slabs cut from the reserved range
+    unsigned int numSlabs() const;
+
+    // granularity of the extra bytes
+    static constexpr size_t classSize = 64;
+    static constexpr unsigned int slabSize = 1024;
+
+protected:
+    struct Slot{
+        Slot* next;
+    };
+
+    struct SizeClass{
+        // bytes between two slots
+        size_t stride;
+        // offsets of the slabs in the reserved range
+        vector<size_t> slabs;
+        // released slots
+        Slot* freeList;
+        // slots are handed out in order from the current slab, the following slabs are unused
+        unsigned int currSlab;
+        unsigned int numUsed;
+    };
+
+    static constexpr size_t unitSize = 8;
+    // the generation of the slot, before the node
+    static constexpr size_t headerSize = 8;
+    static_assert(alignof(T) <= unitSize and sizeof(atomic<unsigned int>) <= headerSize, "a slot should fit the node");
+    // address space of every 32 bit reference, only committed pages take memory
+    static constexpr size_t reservedSize = static_cast<size_t>(unitSize) << 32;
+    static constexpr size_t commitSize = 1 << 21;
+
+    vector<SizeClass> classes;
+    char* arena;
+    // bytes of the range cut into slabs and bytes committed
+    size_t used;
+    size_t committed;
+};
+
+template<typename T>
+NodePool<T>::NodePool():
+    classes{},
+    arena{nullptr},
+    used{0},
+    committed{0}
+{
+    void* ptr = mmap(nullptr, reservedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(ptr == MAP_FAILED)
+        throw bad_alloc();
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, reservedSize, MADV_HUGEPAGE);
+#endif
+    arena = static_cast<char*>(ptr);
+}
+
+template<typename T>
+NodePool<T>::~NodePool()
+{
+    munmap(arena, reservedSize);
+}
+
+template<typename T>
+void* NodePool<T>::allocate(size_t extraSize)
+{
+    size_t classIdx = (extraSize + classSize - 1) / classSize;
+    if(classIdx >= classes.size()){
+        for(size_t i = classes.size(); i <= classIdx; ++i){
+            size_t stride = (headerSize + sizeof(T) + i * classSize + unitSize - 1) / unitSize * unitSize;
+            classes.push_back(SizeClass{stride, {}, nullptr, 0, 0});
+        }
+    }
+    SizeClass& sizeClass = classes[classIdx];
+    if(sizeClass.freeList){
+        Slot* slot = sizeClass.freeList;
+        sizeClass.freeList = slot->next;
+        return slot;
+    }
+    if(sizeClass.slabs.empty() or sizeClass.numUsed == slabSize){
+        // reuse the slabs kept by clear() before cutting a new one
+        if(!sizeClass.slabs.empty())
+            ++sizeClass.currSlab;
+        if(sizeClass.currSlab == sizeClass.slabs.size()){
+            size_t slabBytes = sizeClass.stride * slabSize;
+            if(used + slabBytes > reservedSize)
+                throw bad_alloc();
+            if(used + slabBytes > committed){
+                size_t newCommitted = (used + slabBytes + commitSize - 1) / commitSize * commitSize;
+                if(mprotect(arena + committed, newCommitted - committed, PROT_READ | PROT_WRITE) != 0)
+                    throw bad_alloc();
+                committed = newCommitted;
+            }
+            // the pages are zeroed, the generations start from 0
+            for(unsigned int i = 0; i < slabSize; ++i)
+                new (arena + used + i * sizeClass.stride) atomic<unsigned int>{0};
+            sizeClass.slabs.push_back(used);
+            used += slabBytes;
+        }
+        sizeClass.numUsed = 0;
+    }
+    return arena + sizeClass.slabs[sizeClass.currSlab] + sizeClass.stride * sizeClass.numUsed++ + headerSize;
+}
+
+template<typename T>
+void NodePool<T>::release(void* ptr, size_t extraSize)
+{
+    SizeClass& sizeClass = classes[(extraSize + classSize - 1) / classSize];
+    Slot* slot = static_cast<Slot*>(ptr);
+    slot->next = sizeClass.freeList;
+    sizeClass.freeList = slot;
+}
+
+template<typename T>
+void NodePool<T>::clear()
+{
+    for(SizeClass& sizeClass : classes){
+        sizeClass.freeList = nullptr;
+        sizeClass.currSlab = 0;
+        sizeClass.numUsed = 0;
+    }
+}
+
+template<typename T>
+unsigned int NodePool<T>::numSlabs() const
+{
+    unsigned int sum = 0;
+    for(const SizeClass& sizeClass : classes)
+        sum += sizeClass.slabs.size();
+    return sum;
+}
+
+#endif // NODEPOOL_H
@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "gameclock.h"
+#include "gamestate.h"
+#include "player.h"
+#include "priorcache.h"
+#include "rng.h"
+
+using namespace std;
+
+// ---- options ----
+
+struct ArenaOptions{
+    int boardSize = 5;
+    // upper limit of the number of games, the sprt may stop earlier
+    unsigned int numGames = 1000;
+    // games played at the same time, 0 fills the cores
+    unsigned int concurrency = 0;
+    double seconds = 10;
+    double incrementSeconds = 0;
+    // random pieces placed before the engines play, both games of a pair start from the same opening
+    unsigned int openingMoves = 2;
+    // progress is printed every reportGames games
+    unsigned int reportGames = 50;
+    // engines[0] is A, the engine under test, engines[1] is B
+    EngineOptions engines[2];
+    bool sprt = false;
+    // elo difference of A over B under the null and the alternative hypothesis
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "usage: omega-arena [options]\n"
+            "  two engine configurations play games against each other, the colors alternate\n"
+            "  --a SPEC              configuration of the engine A (default node=UCT-2)\n"
+            "  --b SPEC              configuration of the engine B (default node=UCT-2)\n"
+            "                        SPEC is a comma separated list of node=UCT-2|MCRAVE, recycling=0|1, budget=N,\n"
+            "                        scheduler=stop|even|playouts|nodes, search-budget=N, threads=N, root-parallel=0|1,\n"
+            "                        batch-rollouts=0|1, ponder=0|1 (one more thread during the turn of the opponent)\n"
+            "  --size N              board size (default 5)\n"
+            "  --games N             maximum number of games (default 1000)\n"
+            "  --concurrency N       games played at the same time (default: cores / threads of a game, pondering included)\n"
+            "  --time S              seconds on the clock of each player (default 10)\n"
+            "  --increment S         seconds added to the clock after each move (default 0)\n"
+            "  --opening N           random pieces placed before the engines play (default 2)\n"
+            "  --sprt ELO0,ELO1      stop when the elo of A over B is shown to be ELO0 or ELO1\n"
+            "  --alpha P             false positive rate of the sprt (default 0.05)\n"
+            "  --beta P              false negative rate of the sprt (default 0.05)\n"
+            "  --report N            games between progress reports (default 50)\n"
+            "  --seed N              seed of every random draw\n"
+            "  --prior-dir DIR       directory of the cached initial policies\n");
+}
+
+static bool parseEngine(const string& spec, EngineOptions& options)
+{
+    stringstream stream(spec);
+    string item;
+    while(getline(stream, item, ',')){
+        size_t pos = item.find('=');
+        if(pos == string::npos)
+            return false;
+        string key = item.substr(0, pos);
+        string value = item.substr(pos + 1);
+        if(key == "node")
+            options.node = value;
+        else if(key == "recycling")
+            options.recycling = value == "1";
+        else if(key == "budget")
+            options.budget = strtoul(value.c_str(), nullptr, 10);
+        else if(key == "scheduler")
+            options.scheduler = value;
+        else if(key == "search-budget")
+            options.searchBudget = strtoul(value.c_str(), nullptr, 10);
+        else if(key == "threads")
+            options.numThreads = strtoul(value.c_str(), nullptr, 10);
+        else if(key == "root-parallel")
+            options.rootParallel = value == "1";
+        else if(key == "batch-rollouts")
+            options.batchRollouts = value == "1";
+        else if(key == "ponder")
+            options.ponder = value == "1";
+        else
+            return false;
+    }
+    return (options.node == "UCT-2" or options.node == "MCRAVE") and
+           (options.scheduler == "stop" or options.scheduler == "even" or options.scheduler == "playouts" or
+            options.scheduler == "nodes") and options.searchBudget > 0 and options.numThreads >= 1;
+}
+
+static bool parseArgs(int argc, char** argv, ArenaOptions& options)
+{
+    for(int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if(i + 1 >= argc)
+            return false;
+        string value = argv[++i];
+        if(arg == "--a" or arg == "--b"){
+            if(!parseEngine(value, options.engines[arg == "--a" ? 0 : 1]))
+                return false;
+        }
+        else if(arg == "--size")
+            options.boardSize = atoi(value.c_str());
+        else if(arg == "--games")
+            options.numGames = strtoul(value.c_str(), nullptr, 10);
+        else if(arg == "--concurrency")
+            options.concurrency = strtoul(value.c_str(), nullptr, 10);
+        else if(arg == "--time")
+            options.seconds = atof(value.c_str());
+        else if(arg == "--increment")
+            options.incrementSeconds = atof(value.c_str());
+        else if(arg == "--opening")
+            options.openingMoves = strtoul(value.c_str(), nullptr, 10);
+        else if(arg == "--sprt"){
+            options.sprt = true;
+            if(sscanf(value.c_str(), "%lf,%lf", &options.elo0, &options.elo1) != 2)
+                return false;
+        }
+        else if(arg == "--alpha")
+            options.alpha = atof(value.c_str());
+        else if(arg == "--beta")
+            options.beta = atof(value.c_str());
+        else if(arg == "--report")
+            options.reportGames = strtoul(value.c_str(), nullptr, 10);
+        else if(arg == "--seed")
+            Rng::setSeed(strtoull(value.c_str(), nullptr, 10));
+        else if(arg == "--prior-dir")
+            PriorCache::setDirectory(value);
+        else
+            return false;
+    }
+    return options.boardSize >= 2 and options.numGames > 0 and options.seconds > 0 and
+           options.incrementSeconds >= 0 and options.elo0 < options.elo1 and options.alpha > 0 and
+           options.alpha < 0.5 and options.beta > 0 and options.beta < 0.5 and options.reportGames > 0;
+}
+
+// ---- statistics ----
+
+struct Tally
+/*
+ * results of A against B. A game scores 1 for a win, 0.5 for a draw and 0 for a loss. The sprt approximates the score
+ * by a normal distribution with the variance of the game results, the interval is the Wilson interval of the score.
+ * The elo difference follows from the logistic model.
+ */
+{
+    unsigned int numWins = 0;
+    unsigned int numDraws = 0;
+    unsigned int numLosses = 0;
+
+    unsigned int numGames() const{
+        return numWins + numDraws + numLosses;
+    }
+
+    double score() const{
+        return numGames() > 0 ? (numWins + 0.5 * numDraws) / numGames() : 0.5;
+    }
+
+    // variance of the result of one game
+    double variance() const{
+        if(numGames() == 0)
+            return 0;
+        double s = score();
+        return (numWins * (1 - s) * (1 - s) + numDraws * (0.5 - s) * (0.5 - s) + numLosses * s * s) / numGames();
+    }
+
+    static double elo(double score){
+        // a score of 0 or 1 is infinitely many elo away, that side of an interval is open
+        if(score <= 1e-9)
+            return -INFINITY;
+        if(score >= 1 - 1e-9)
+            return INFINITY;
+        return -400 * log10(1 / score - 1);
+    }
+
+    static double expectedScore(double elo){
+        return 1 / (1 + pow(10, -elo / 400));
+    }
+
+    // bounds of the elo difference with 95% confidence. The Wilson interval of the score stays within [0, 1] and keeps
+    // a width after a sweep, where the interval of the normal approximation collapses to a point
+    pair<double, double> eloInterval() const{
+        if(numGames() == 0)
+            return {-INFINITY, INFINITY};
+        const double z = 1.959964;
+        double n = numGames();
+        double s = score();
+        double center = (s + z * z / (2 * n)) / (1 + z * z / n);
+        double margin = z / (1 + z * z / n) * sqrt(s * (1 - s) / n + z * z / (4 * n * n));
+        return {elo(center - margin), elo(center + margin)};
+    }
+
+    // log likelihood ratio of the elo difference elo1 over elo0
+    double llr(double elo0, double elo1) const{
+        double var = variance();
+        if(var <= 0)
+            return 0;
+        double s0 = expectedScore(elo0);
+        double s1 = expectedScore(elo1);
+        return numGames() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * var);
+    }
+};
+
+// ---- games ----
+
+// white: 1 black: 0 draw: 0.5, a player who overruns the clock loses
+static double playGame(Player* players[2], unsigned int openingMoves, Rng& rng, const TimeControl& control,
+                       bool& lostOnTime)
+{
+    GameState referee{players[WHITE]->state.getBoardSize(), GameState::FreeNeighbours};
+    for(unsigned int color = WHITE; color <= BLACK; ++color){
+        players[color]->reset();
+        players[color]->clock.reset(control);
+    }
+    for(unsigned int i = 0; i < openingMoves and !referee.end(); ++i){
+        auto it = referee.validMoves.begin();
+        for(unsigned int n = rng.below(referee.validMoves.size()); n > 0; --n)
+            ++it;
+        unsigned int moveIdx = *it;
+        referee.update(moveIdx);
+        for(unsigned int color = WHITE; color <= BLACK; ++color){
+            players[color]->state.update(moveIdx);
+            players[color]->update(moveIdx);
+        }
+    }
+    lostOnTime = false;
+    while(!referee.end()){
+        Color color = referee.getCurrentPlayer();
+        Player& player = *players[color];
+        unsigned int numTaken = player.state.numTakenMoves();
+        player.clock.start();
+        player.selectBestMoves();
+        player.clock.stop();
+        if(player.clock.remaining() < 0){
+            lostOnTime = true;
+            return color == WHITE ? 0 : 1;
+        }
+        Player& opponent = *players[color == WHITE ? BLACK : WHITE];
+        for(unsigned int i = numTaken; i < player.state.numTakenMoves(); ++i){
+            unsigned int moveIdx = player.state.takenMove(i);
+            referee.update(moveIdx);
+            opponent.state.update(moveIdx);
+            opponent.update(moveIdx);
+        }
+    }
+    return referee.getScore();
+}
+
+// ---- arena ----
+
+class Arena
+/*
+ * plays the games on concurrency threads. Each thread owns a pair of players and takes the next game index until the
+ * number of games is reached or the sprt is decided. Games 2k and 2k+1 start from the same random opening, A plays
+ * white in the first one and black in the second one. The games still running when the sprt is decided are counted.
+ */
+{
+public:
+    explicit Arena(const ArenaOptions& options):
+        options{options},
+        nextGame{0},
+        stop{false},
+        numTimeLosses{0},
+        decision{0}
+    {
+        control.mainMsecs = options.seconds * 1000;
+        control.incrementMsecs = options.incrementSeconds * 1000;
+        lowerBound = log(options.beta / (1 - options.alpha));
+        upperBound = log((1 - options.beta) / options.alpha);
+    }
+
+    void run(){
+        unsigned int concurrency = options.concurrency;
+        if(concurrency == 0){
+            // a pondering engine searches on one more thread during the turn of the other engine
+            const EngineOptions& a = options.engines[0];
+            const EngineOptions& b = options.engines[1];
+            unsigned int numThreads = max(a.numThreads + b.ponder, b.numThreads + a.ponder);
+            concurrency = max(1u, thread::hardware_concurrency() / numThreads);
+        }
+        concurrency = min(concurrency, options.numGames);
+        // the initial policy is computed once on every core before the workers map it
+        GameState state{options.boardSize, GameState::FreeNeighbours};
+        PriorCache::load(&state);
+        printf("board size: %d\ngames: %u\nconcurrency: %u\n", options.boardSize, options.numGames, concurrency);
+        fflush(stdout);
+        vector<thread> workers;
+        for(unsigned int i = 0; i < concurrency; ++i)
+            workers.emplace_back(&Arena::work, this);
+        for(thread& worker : workers)
+            worker.join();
+        report(stdout);
+    }
+
+private:
+    void work(){
+        EnginePlayer engineA{options.boardSize, options.engines[0]};
+        EnginePlayer engineB{options.boardSize, options.engines[1]};
+        engineA.setup();
+        engineB.setup();
+        while(!stop){
+            unsigned int game = nextGame++;
+            if(game >= options.numGames)
+                break;
+            bool isWhite = game % 2 == 0;
+            Player* players[2];
+            players[WHITE] = isWhite ? static_cast<Player*>(&engineA) : &engineB;
+            players[BLACK] = isWhite ? static_cast<Player*>(&engineB) : &engineA;
+            Rng rng{Rng::getSeed() + game / 2, Rng::OpeningStream};
+            bool lostOnTime;
+            double outcome = playGame(players, options.openingMoves, rng, control, lostOnTime);
+            // the score of A
+            double score = isWhite ? outcome : 1 - outcome;
+            lock_guard<mutex> lock(mtx);
+            if(score == 1)
+                ++tally.numWins;
+            else if(score == 0)
+                ++tally.numLosses;
+            else
+                ++tally.numDraws;
+            numTimeLosses += lostOnTime;
+            if(options.sprt and decision == 0){
+                double llr = tally.llr(options.elo0, options.elo1);
+                if(llr >= upperBound or llr <= lowerBound){
+                    decision = llr >= upperBound ? 1 : -1;
+                    stop = true;
+                }
+            }
+            if(tally.numGames() % options.reportGames == 0)
+                report(stderr);
+        }
+    }
+
+    // expects the lock to be held or the workers to be done
+    void report(FILE* file) const{
+        pair<double, double> interval = tally.eloInterval();
+        fprintf(file, "games %u: A wins %u, B wins %u, draws %u, time losses %u, score %.3f, elo %+.1f [%+.1f, %+.1f]",
+                tally.numGames(), tally.numWins, tally.numLosses, tally.numDraws, numTimeLosses, tally.score(),
+                Tally::elo(tally.score()), interval.first, interval.second);
+        if(options.sprt){
+            fprintf(file, ", llr %.2f [%.2f, %.2f]", tally.llr(options.elo0, options.elo1), lowerBound, upperBound);
+            if(decision != 0)
+                fprintf(file, ", H%d accepted", decision > 0 ? 1 : 0);
+        }
+        fprintf(file, "\n");
+        fflush(file);
+    }
+
+    const ArenaOptions& options;
+    TimeControl control;
+    atomic<unsigned int> nextGame;
+    atomic<bool> stop;
+    // guards the results
+    mutable mutex mtx;
+    Tally tally;
+    unsigned int numTimeLosses;
+    // 1 if H1 (elo1) is accepted, -1 if H0 (elo0) is accepted
+    int decision;
+    double lowerBound;
+    double upperBound;
+};
+
+int main(int argc, char** argv)
+{
+    ArenaOptions options;
+    if(argc > 1 and string(argv[1]) == "--help"){
+        printUsage();
+        return 0;
+    }
+    if(!parseArgs(argc, argv, options)){
+        printUsage();
+        return 2;
+    }
+    Arena arena{options};
+    arena.run();
+    return 0;
+}
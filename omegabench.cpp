@@ -0,0 +1,681 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "batchrollout.h"
+#include "bitgamestate.h"
+#include "gamestate.h"
+#include "groupscores.h"
+#include "hmcravenode.h"
+#include "mast.h"
+#include "mcts.h"
+#include "parallelmcts.h"
+#include "playoutbudgetscheduler.h"
+#include "priorcache.h"
+#include "rng.h"
+#include "uctnode.h"
+
+using namespace std;
+
+// ---- options ----
+
+struct BenchOptions{
+    unsigned int minSize = 3;
+    unsigned int maxSize = 10;
+    // measured time of each case and board size
+    double minMsecs = 200;
+    // names of the cases to run, all when empty
+    vector<string> cases;
+    // results of an earlier run to compare with
+    string baseline;
+    // playouts of a search round of the mcts_run and threads cases
+    unsigned int numPlayouts = 2000;
+    // worker counts of the threads case
+    vector<unsigned int> numThreads = {1, 2, 4};
+};
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "usage: omega-bench [options]\n"
+            "  the results are printed as csv: case,node,size,ops,ns_per_op,ops_per_sec[,speedup]\n"
+            "  --sizes A-B           board sizes (default 3-10)\n"
+            "  --case NAME,...       cases to run (default all): gamestate_update_undo, state_playout,\n"
+            "                        gamestate_merge, scoring, mast_select, mast_update, mast_rollout, mast_rollout_list,\n"
+            "                        batch_rollout, tt_store, tt_load, tt_probe, tt_probe_list, node_select, mcts_run,\n"
+            "                        threads\n"
+            "  --min-time MS         measured milliseconds of each case and size (default 200)\n"
+            "  --playouts N          playouts of a search in mcts_run and threads (default 2000)\n"
+            "  --threads N,...       worker counts of the tree-parallel search in threads (default 1,2,4)\n"
+            "  --baseline FILE       csv of an earlier run, the speedup over it is added to each row\n"
+            "  --seed N              seed of every random draw\n"
+            "  --prior-dir DIR       directory of the cached initial policies\n");
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& options)
+{
+    for(int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if(i + 1 >= argc)
+            return false;
+        string value = argv[++i];
+        if(arg == "--sizes"){
+            if(sscanf(value.c_str(), "%u-%u", &options.minSize, &options.maxSize) != 2)
+                options.minSize = options.maxSize = atoi(value.c_str());
+        }
+        else if(arg == "--case"){
+            stringstream stream(value);
+            string item;
+            while(getline(stream, item, ','))
+                options.cases.push_back(item);
+        }
+        else if(arg == "--min-time")
+            options.minMsecs = atof(value.c_str());
+        else if(arg == "--playouts")
+            options.numPlayouts = strtoul(value.c_str(), nullptr, 10);
+        else if(arg == "--threads"){
+            options.numThreads.clear();
+            stringstream stream(value);
+            string item;
+            while(getline(stream, item, ','))
+                options.numThreads.push_back(atoi(item.c_str()));
+        }
+        else if(arg == "--baseline")
+            options.baseline = value;
+        else if(arg == "--seed")
+            Rng::setSeed(strtoull(value.c_str(), nullptr, 10));
+        else if(arg == "--prior-dir")
+            PriorCache::setDirectory(value);
+        else
+            return false;
+    }
+    return options.minSize >= 2 and options.minSize <= options.maxSize and options.minMsecs > 0 and
+           options.numPlayouts > 0 and !options.numThreads.empty() and
+           find(options.numThreads.begin(), options.numThreads.end(), 0) == options.numThreads.end();
+}
+
+// ---- measurement ----
+
+struct Result{
+    string name;
+    string node;
+    unsigned int size;
+    unsigned long int numOps;
+    // of the fastest round
+    double nsPerOp;
+};
+
+class Bench
+/*
+ * runs the cases and prints a row per case, node type and board size. A case is measured in rounds: the setup of a
+ * round is not timed, the body returns the number of operations it did. After a warm up round, rounds are repeated
+ * until the measured time reaches minMsecs. The time per operation is the one of the fastest round, the other
+ * processes of the machine only ever slow a round down.
+ */
+{
+public:
+    explicit Bench(const BenchOptions& options):
+        options{options}
+    {
+        if(!options.baseline.empty())
+            loadBaseline(options.baseline);
+        printf("case,node,size,ops,ns_per_op,ops_per_sec%s\n", baseline.empty() ? "" : ",speedup");
+    }
+
+    bool enabled(const string& name) const{
+        return options.cases.empty() or find(options.cases.begin(), options.cases.end(), name) != options.cases.end();
+    }
+
+    void measure(const string& name, const string& node, unsigned int size, const function<void()>& setup,
+                 const function<unsigned long int()>& body){
+        // caches, branch predictors and the lazily allocated buffers of the engine
+        setup();
+        body();
+        Result result{name, node, size, 0, 0};
+        double totalNsecs = 0;
+        vector<double> roundNsecs;
+        while(totalNsecs < options.minMsecs * 1e6 or roundNsecs.size() < 5){
+            setup();
+            auto startTime = chrono::steady_clock::now();
+            unsigned long int numOps = body();
+            double nsecs = chrono::duration<double, nano>(chrono::steady_clock::now() - startTime).count();
+            result.numOps += numOps;
+            totalNsecs += nsecs;
+            roundNsecs.push_back(nsecs / max(numOps, 1UL));
+        }
+        result.nsPerOp = *min_element(roundNsecs.begin(), roundNsecs.end());
+        print(result);
+    }
+
+    const BenchOptions& options;
+
+private:
+    static string key(const string& name, const string& node, unsigned int size){
+        return name + "," + node + "," + to_string(size);
+    }
+
+    void loadBaseline(const string& path){
+        ifstream file(path);
+        if(!file){
+            fprintf(stderr, "could not read the baseline %s\n", path.c_str());
+            return;
+        }
+        string line;
+        // the header
+        getline(file, line);
+        while(getline(file, line)){
+            stringstream stream(line);
+            string name, node, size, ops, nsPerOp;
+            if(getline(stream, name, ',') and getline(stream, node, ',') and getline(stream, size, ',') and
+               getline(stream, ops, ',') and getline(stream, nsPerOp, ','))
+                baseline[name + "," + node + "," + size] = atof(nsPerOp.c_str());
+        }
+    }
+
+    void print(const Result& result){
+        printf("%s,%s,%u,%lu,%.3f,%.1f", result.name.c_str(), result.node.c_str(), result.size, result.numOps,
+               result.nsPerOp, 1e9 / result.nsPerOp);
+        if(!baseline.empty()){
+            auto it = baseline.find(key(result.name, result.node, result.size));
+            if(it != baseline.end())
+                printf(",%.3f", it->second / result.nsPerOp);
+            else
+                printf(",");
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    // ns per operation of the baseline rows
+    map<string, double> baseline;
+};
+
+// ---- game state cases ----
+
+// uniformly random valid move, the valid moves are iterated in a random order but the first one is not random
+static unsigned int randomMove(GameState& state, Rng& rng)
+{
+    auto it = state.validMoves.begin();
+    for(unsigned int n = rng.below(state.validMoves.size()); n > 0; --n)
+        ++it;
+    return *it;
+}
+
+static void benchGameState(Bench& bench, unsigned int size, Rng& rng)
+{
+    GameState state{static_cast<int>(size), GameState::FreeNeighbours};
+    if(bench.enabled("gamestate_update_undo")){
+        // a random game is replayed and undone, an operation is an update and its undo
+        vector<unsigned int> game;
+        while(!state.end()){
+            game.push_back(randomMove(state, rng));
+            state.update(game.back());
+        }
+        state.reset();
+        bench.measure("gamestate_update_undo", "-", size, []{}, [&]{
+            for(unsigned int moveIdx : game)
+                state.update(moveIdx);
+            for(size_t i = 0; i < game.size(); ++i)
+                state.undo();
+            return game.size();
+        });
+    }
+    if(bench.enabled("state_playout")){
+        // random games played to the end, scored and undone on GameState and on the bitboard of the rollouts, an
+        // operation is a game. The node column gives the state.
+        vector<vector<unsigned int>> games(64);
+        for(vector<unsigned int>& game : games){
+            state.reset();
+            while(!state.end()){
+                game.push_back(randomMove(state, rng));
+                state.update(game.back());
+            }
+        }
+        state.reset();
+        double checksum = 0;
+        bench.measure("state_playout", "GameState", size, []{}, [&]{
+            for(const vector<unsigned int>& game : games){
+                for(unsigned int moveIdx : game)
+                    state.update(moveIdx);
+                checksum += state.getScore();
+                for(size_t i = 0; i < game.size(); ++i)
+                    state.undo();
+            }
+            return games.size();
+        });
+        if(static_cast<int>(size) <= BitGameState::maxBoardSize){
+            BitGameState bitState{static_cast<int>(size)};
+            bench.measure("state_playout", "BitGameState", size, []{}, [&]{
+                for(const vector<unsigned int>& game : games){
+                    for(unsigned int moveIdx : game)
+                        bitState.update(moveIdx);
+                    checksum += bitState.getScore();
+                    for(size_t i = 0; i < game.size(); ++i)
+                        bitState.undo();
+                }
+                return games.size();
+            });
+        }
+        if(checksum == 1)
+            fprintf(stderr, "\n");
+    }
+    if(bench.enabled("gamestate_merge")){
+        // moves of a half filled board that join two or more groups of the color to play, an operation is such an
+        // update and its undo. Small boards are drawn again until they have one.
+        vector<unsigned int> merges;
+        for(unsigned int attempt = 0; attempt < 100 and merges.empty(); ++attempt){
+            state.reset();
+            while(state.numRemainingMoves() > state.cellNum / 2)
+                state.update(randomMove(state, rng));
+            Color color = state.getCurrentColor();
+            vector<unsigned int> moves(state.validMoves.begin(), state.validMoves.end());
+            for(unsigned int moveIdx : moves){
+                unsigned int cellIdx = moveIdx % state.cellNum;
+                state.update(moveIdx);
+                unsigned int mergedSize = state.groupSize(cellIdx);
+                state.undo();
+                // the stone joins a neighbour group and at least one other
+                for(unsigned int nIdx : state.neighbourIdxs(cellIdx)){
+                    if(state.cellColor(nIdx) == color and state.groupSize(nIdx) + 1 < mergedSize){
+                        merges.push_back(moveIdx);
+                        break;
+                    }
+                }
+            }
+        }
+        if(!merges.empty()){
+            bench.measure("gamestate_merge", "-", size, []{}, [&]{
+                for(unsigned int moveIdx : merges){
+                    state.update(moveIdx);
+                    state.undo();
+                }
+                return merges.size();
+            });
+        }
+        state.reset();
+    }
+    if(bench.enabled("scoring")){
+        // the group sizes of the final positions of random games, an operation compares the scores of one position
+        // the way getScore() ends a playout. Near ties fall back to the exact products.
+        vector<GroupScores> positions(64, GroupScores{state.cellNum});
+        for(GroupScores& scores : positions){
+            state.reset();
+            while(!state.end())
+                state.update(randomMove(state, rng));
+            // a group of n stones is counted by each of its cells
+            vector<unsigned int> numCells[2] = {vector<unsigned int>(state.cellNum + 1), vector<unsigned int>(state.cellNum + 1)};
+            for(unsigned int cellIdx = 0; cellIdx < state.cellNum; ++cellIdx){
+                Color color = state.cellColor(cellIdx);
+                if(color != EMPTY)
+                    ++numCells[color][state.groupSize(cellIdx)];
+            }
+            for(unsigned int color = WHITE; color <= BLACK; ++color){
+                for(unsigned int groupSize = 1; groupSize <= state.cellNum; ++groupSize){
+                    for(unsigned int i = 0; i < numCells[color][groupSize] / groupSize; ++i)
+                        scores.add(static_cast<Color>(color), groupSize);
+                }
+            }
+        }
+        long int checksum = 0;
+        bench.measure("scoring", "-", size, []{}, [&]{
+            for(const GroupScores& scores : positions)
+                checksum += scores.compare();
+            return positions.size();
+        });
+        if(checksum == 1)
+            fprintf(stderr, "\n");
+        state.reset();
+    }
+}
+
+// ---- policy cases ----
+
+static void benchPolicy(Bench& bench, unsigned int size, Rng& rng)
+{
+    GameState state{static_cast<int>(size), GameState::FreeNeighbours};
+    MAST policy{&state};
+    policy.setup();
+    // a position in the middle of the game
+    while(state.numRemainingMoves() > state.cellNum / 2)
+        state.update(randomMove(state, rng));
+    if(bench.enabled("mast_select")){
+        unsigned long int checksum = 0;
+        bench.measure("mast_select", "-", size, []{}, [&]{
+            for(unsigned int i = 0; i < 1000; ++i)
+                checksum += policy.select();
+            return 1000UL;
+        });
+        if(checksum == 1)
+            fprintf(stderr, "\n");
+    }
+    if(bench.enabled("mast_update")){
+        // the moves of a playout from the middle of the game, an operation updates the score of one move
+        vector<unsigned int> moves;
+        for(unsigned int i = 0; i < state.numRemainingMoves(); ++i)
+            moves.push_back(rng.below(state.moveNum()));
+        bench.measure("mast_update", "-", size, []{}, [&]{
+            for(unsigned int i = 0; i < moves.size(); ++i)
+                policy.addMove(static_cast<Color>(i % 2), moves[i]);
+            policy.update(rng.below(2));
+            return moves.size();
+        });
+    }
+    if(bench.enabled("mast_rollout") or bench.enabled("mast_rollout_list")){
+        // playouts from the middle of the game to its end, an operation is a playout
+        unsigned int numMoves = state.numRemainingMoves();
+        unsigned long int checksum = 0;
+        if(bench.enabled("mast_rollout")){
+            bench.measure("mast_rollout", "-", size, []{}, [&]{
+                for(unsigned int i = 0; i < 100; ++i){
+                    while(!state.end()){
+                        unsigned int moveIdx = policy.select();
+                        policy.addMove(state.getCurrentPlayer(), moveIdx);
+                        state.update(moveIdx);
+                    }
+                    checksum += state.getScore() > 0.5;
+                    // the scores stay the same as in the reference
+                    policy.discard();
+                    for(unsigned int j = 0; j < numMoves; ++j)
+                        state.undo();
+                }
+                return 100UL;
+            });
+        }
+        if(bench.enabled("mast_rollout_list")){
+            // reference: the sampler that MAST replaced, it rebuilds the weights of the valid moves into a list and a
+            // distribution with a new generator at each draw
+            bench.measure("mast_rollout_list", "-", size, []{}, [&]{
+                for(unsigned int i = 0; i < 100; ++i){
+                    while(!state.end()){
+                        default_random_engine generator;
+                        Color player = state.getCurrentPlayer();
+                        list<int> probs;
+                        vector<unsigned int> idxMap;
+                        idxMap.reserve(state.validMoves.size());
+                        for(unsigned int moveIdx : state.validMoves){
+                            idxMap.push_back(moveIdx);
+                            // the default temperature of MAST
+                            probs.push_back(exp(policy.getScore(moveIdx, player) / 5) + 1e-8);
+                        }
+                        discrete_distribution<> distribution(probs.begin(), probs.end());
+                        state.update(idxMap[distribution(generator)]);
+                    }
+                    checksum += state.getScore() > 0.5;
+                    for(unsigned int j = 0; j < numMoves; ++j)
+                        state.undo();
+                }
+                return 100UL;
+            });
+        }
+        if(checksum == 1)
+            fprintf(stderr, "\n");
+    }
+    if(bench.enabled("batch_rollout")){
+        // the lockstep uniformly random playouts of a leaf in the middle of the game, an operation is a playout of one
+        // lane. Compare with mast_rollout.
+        BatchRollout rollouts{&state};
+        rollouts.setup();
+        double checksum = 0;
+        bench.measure("batch_rollout", "-", size, []{}, [&]{
+            for(unsigned int i = 0; i < 100; ++i)
+                checksum += rollouts.run();
+            return 100UL * BatchRollout::numLanes;
+        });
+        if(checksum == 1)
+            fprintf(stderr, "\n");
+    }
+}
+
+// ---- search cases ----
+
+template<typename NodeType>
+class BenchSearch: public MCTS<NodeType, MAST, PlayoutBudgetScheduler>
+/*
+ * search with access to its root and table, the cases drive them directly
+ */
+{
+    typedef MCTS<NodeType, MAST, PlayoutBudgetScheduler> Base;
+    // the node type wrapped by RecyclingNode
+    typedef typename WType<NodeType>::type WrappedType;
+
+public:
+    using Base::Base;
+
+    // playouts from the root without playing the best moves
+    void grow(unsigned int numPlayouts){
+        this->bind();
+        for(unsigned int i = 0; i < numPlayouts; ++i){
+            this->selection();
+            this->backpropagation(this->simulation());
+        }
+    }
+
+    // selects a child of the root and goes back, the fifo of a recycling node is not touched (it is part of mcts_run)
+    unsigned long int selectRoot(unsigned int n){
+        this->bind();
+        unsigned long int checksum = 0;
+        for(unsigned int i = 0; i < n; ++i){
+            checksum += reinterpret_cast<uintptr_t>(static_cast<WrappedType*>(this->root)->template select<NodeType>());
+            unsigned int moveIdx = this->gameState->takenMove();
+            this->gameState->undo();
+            this->tTable->update(moveIdx);
+        }
+        return checksum;
+    }
+
+    // probes the positions of the games from the root after each move, the way a playout probes the table
+    unsigned long int probe(const vector<vector<unsigned int>>& games){
+        this->bind();
+        unsigned long int checksum = 0;
+        for(const vector<unsigned int>& game : games){
+            for(unsigned int moveIdx : game){
+                this->tTable->update(moveIdx);
+                checksum += reinterpret_cast<uintptr_t>(this->tTable->load());
+            }
+            for(unsigned int moveIdx : game)
+                this->tTable->update(moveIdx);
+        }
+        return checksum;
+    }
+
+    // the zobrist key of each move and the nodes found by the probes of the games
+    void probedNodes(const vector<vector<unsigned int>>& games, vector<unsigned long int>& moveKeys, vector<NodeType*>& nodes){
+        this->bind();
+        moveKeys.resize(this->gameState->moveNum());
+        for(unsigned int moveIdx = 0; moveIdx < moveKeys.size(); ++moveIdx){
+            unsigned long int key = this->tTable->positionKey();
+            this->tTable->update(moveIdx);
+            moveKeys[moveIdx] = key ^ this->tTable->positionKey();
+            this->tTable->update(moveIdx);
+        }
+        for(const vector<unsigned int>& game : games){
+            for(unsigned int moveIdx : game){
+                this->tTable->update(moveIdx);
+                nodes.push_back(this->tTable->load());
+            }
+            for(unsigned int moveIdx : game)
+                this->tTable->update(moveIdx);
+        }
+    }
+
+    // stores or loads the positions two moves away from the root given by pairs of moves
+    unsigned long int access(const vector<pair<unsigned int, unsigned int>>& positions, bool store){
+        this->bind();
+        unsigned long int checksum = 0;
+        for(const auto& position : positions){
+            this->tTable->update(position.first);
+            this->tTable->update(position.second);
+            checksum += reinterpret_cast<uintptr_t>(store ? this->tTable->store() : this->tTable->load());
+            this->tTable->update(position.second);
+            this->tTable->update(position.first);
+        }
+        return checksum;
+    }
+};
+
+template<typename NodeType>
+static void benchSearch(Bench& bench, const string& node, unsigned int size, Rng& rng)
+{
+    GameState state{static_cast<int>(size), GameState::FreeNeighbours};
+    MAST policy{&state};
+    ZHashTable<NodeType> tTable{&state, &policy};
+    PlayoutBudgetScheduler scheduler{bench.options.numPlayouts};
+    BenchSearch<NodeType> search{&tTable, &state, &policy, &scheduler};
+    search.reset();
+    unsigned long int checksum = 0;
+    if(bench.enabled("tt_store") or bench.enabled("tt_load")){
+        // distinct positions, fewer than the node budget of the recycling table
+        vector<pair<unsigned int, unsigned int>> positions;
+        for(unsigned int first = 0; first < state.moveNum(); ++first){
+            for(unsigned int second = first + 1; second < state.moveNum(); ++second)
+                positions.push_back({first, second});
+        }
+        shuffle(positions.begin(), positions.end(), rng);
+        positions.resize(min<size_t>(positions.size(), 4096));
+        if(bench.enabled("tt_store")){
+            bench.measure("tt_store", node, size, [&]{ search.reset(); }, [&]{
+                checksum += search.access(positions, true);
+                return positions.size();
+            });
+        }
+        if(bench.enabled("tt_load")){
+            search.reset();
+            search.access(positions, true);
+            bench.measure("tt_load", node, size, []{}, [&]{
+                checksum += search.access(positions, false);
+                return positions.size();
+            });
+        }
+    }
+    if(bench.enabled("tt_probe") or bench.enabled("tt_probe_list")){
+        // the table after a search of about one second on a small board, probed after each move of random games from
+        // the root the way the playouts probe it: the first moves hit, the later ones miss
+        search.reset();
+        search.grow(20000);
+        vector<vector<unsigned int>> games(64);
+        unsigned long int numProbes = 0;
+        for(vector<unsigned int>& game : games){
+            while(!state.end()){
+                game.push_back(randomMove(state, rng));
+                state.update(game.back());
+            }
+            for(size_t i = 0; i < game.size(); ++i)
+                state.undo();
+            numProbes += game.size();
+        }
+        if(bench.enabled("tt_probe")){
+            bench.measure("tt_probe", node, size, []{}, [&]{
+                checksum += search.probe(games);
+                return numProbes;
+            });
+        }
+        if(bench.enabled("tt_probe_list")){
+            // reference: the list per hash code that the table replaced, with its own zobrist codes and the keys of the
+            // table. It holds the nodes found by the probes.
+            vector<unsigned long int> moveKeys;
+            vector<NodeType*> nodes;
+            search.probedNodes(games, moveKeys, nodes);
+            const unsigned long int mask = (1UL << 20) - 1;
+            vector<unsigned long int> moveCodes(moveKeys.size());
+            for(unsigned long int& code : moveCodes)
+                code = rng() & mask;
+            vector<list<NodeType*>> lists(mask + 1);
+            auto probed = nodes.begin();
+            for(const vector<unsigned int>& game : games){
+                unsigned long int code = 0;
+                for(unsigned int moveIdx : game){
+                    code ^= moveCodes[moveIdx];
+                    list<NodeType*>& nodeList = lists[code];
+                    if(*probed and find(nodeList.begin(), nodeList.end(), *probed) == nodeList.end())
+                        nodeList.push_front(*probed);
+                    ++probed;
+                }
+            }
+            bench.measure("tt_probe_list", node, size, []{}, [&]{
+                for(const vector<unsigned int>& game : games){
+                    unsigned long int code = 0;
+                    unsigned long int key = 0;
+                    for(unsigned int moveIdx : game){
+                        code ^= moveCodes[moveIdx];
+                        key ^= moveKeys[moveIdx];
+                        for(NodeType* listNode : lists[code]){
+                            if(listNode->key == key){
+                                checksum += reinterpret_cast<uintptr_t>(listNode);
+                                break;
+                            }
+                        }
+                    }
+                }
+                return numProbes;
+            });
+        }
+    }
+    if(bench.enabled("node_select")){
+        // the children of the root after a short search
+        search.reset();
+        search.grow(bench.options.numPlayouts);
+        bench.measure("node_select", node, size, []{}, [&]{
+            checksum += search.selectRoot(1000);
+            return 1000UL;
+        });
+    }
+    if(bench.enabled("mcts_run")){
+        // a search on the empty board, an operation is a playout
+        bench.measure("mcts_run", node, size, [&]{ state.reset(); search.reset(); }, [&]{
+            search.run();
+            return bench.options.numPlayouts;
+        });
+        state.reset();
+    }
+    if constexpr(!ZHashTable<NodeType>::isRecycledType){
+        if(bench.enabled("threads")){
+            // the tree-parallel search on the empty board, an operation is a playout of any worker. The node column
+            // gives the number of workers, the rows only show a speedup with as many free cores
+            for(unsigned int numThreads : bench.options.numThreads){
+                TreeParallelMCTS<NodeType, MAST, PlayoutBudgetScheduler> parallel{&tTable, &state, &policy, &scheduler, numThreads};
+                bench.measure("threads", node + "/t" + to_string(numThreads), size, [&]{ state.reset(); parallel.reset(); }, [&]{
+                    parallel.run();
+                    return parallel.playouts();
+                });
+                state.reset();
+            }
+        }
+    }
+    if(checksum == 1)
+        fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if(argc > 1 and string(argv[1]) == "--help"){
+        printUsage();
+        return 0;
+    }
+    if(!parseArgs(argc, argv, options)){
+        printUsage();
+        return 2;
+    }
+    Bench bench{options};
+    Rng rng{Rng::BenchStream};
+    for(unsigned int size = options.minSize; size <= options.maxSize; ++size){
+        benchGameState(bench, size, rng);
+        benchPolicy(bench, size, rng);
+        benchSearch<UCTNode>(bench, "UCT-2", size, rng);
+        benchSearch<RecyclingNode<UCTNode>>(bench, "UCT-2/recycling", size, rng);
+        benchSearch<RAVENode>(bench, "MCRAVE", size, rng);
+        benchSearch<RecyclingNode<RAVENode>>(bench, "MCRAVE/recycling", size, rng);
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+#include "gameclock.h"
+#include "gamestate.h"
+#include "player.h"
+#include "priorcache.h"
+#include "rng.h"
+
+using namespace std;
+
+// ---- options ----
+
+struct CliOptions{
+    // "play" or "analyse"
+    string command = "play";
+    int boardSize = 5;
+    // on the clock of each player
+    double seconds = 60;
+    double incrementSeconds = 0;
+    double periodSeconds = 0;
+    unsigned int numPeriods = 0;
+    // "random" or "engine"
+    string opponent = "random";
+    Color engineColor = WHITE;
+    // cells of the moves played before the analysis, the colors alternate from white
+    string moves;
+    EngineOptions engine;
+};
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "usage: omega-cli [play|analyse] [options]\n"
+            "  play                  the engine plays a game and the moves are printed (default)\n"
+            "  analyse               the engine searches the moves of the position given by --moves\n"
+            "  --size N              board size (default 5)\n"
+            "  --time S              seconds on the clock of each player (default 60)\n"
+            "  --increment S         seconds added to the clock after each move (default 0)\n"
+            "  --byoyomi S           seconds of a byo-yomi period after the main time (default 0)\n"
+            "  --periods N           number of byo-yomi periods (default 0)\n"
+            "  --opponent NAME       random or engine (default random)\n"
+            "  --color NAME          color of the engine against the random opponent: white or black (default white)\n"
+            "  --moves C,C,...       cells of the moves already played, the colors alternate from white\n"
+            "  --node NAME           UCT-2 or MCRAVE (default UCT-2)\n"
+            "  --recycling           node recycling\n"
+            "  --budget N            maximum number of nodes with recycling (default 50000)\n"
+            "  --threads N           search threads (default 1)\n"
+            "  --root-parallel       root instead of tree parallelization\n"
+            "  --scheduler NAME      stop or even time distribution, playouts or nodes budget per search (default stop)\n"
+            "  --search-budget N     playouts or stored nodes per search with the budget schedulers (default 10000)\n"
+            "  --batch-rollouts      evaluate leaves with batched random playouts (single thread)\n"
+            "  --ponder              search on another thread during the turn of the opponent\n"
+            "  --seed N              seed of every random draw\n"
+            "  --prior-dir DIR       directory of the cached initial policies\n");
+}
+
+static bool parseArgs(int argc, char** argv, CliOptions& options)
+{
+    int i = 1;
+    if(i < argc and argv[i][0] != '-')
+        options.command = argv[i++];
+    if(options.command != "play" and options.command != "analyse")
+        return false;
+    for(; i < argc; ++i){
+        string arg = argv[i];
+        // options with a value
+        if(arg == "--size" or arg == "--time" or arg == "--increment" or arg == "--byoyomi" or arg == "--periods" or
+           arg == "--opponent" or arg == "--color" or arg == "--moves" or arg == "--node" or arg == "--scheduler" or
+           arg == "--search-budget" or arg == "--budget" or arg == "--threads" or arg == "--seed" or arg == "--prior-dir"){
+            if(i + 1 >= argc)
+                return false;
+            string value = argv[++i];
+            if(arg == "--size")
+                options.boardSize = atoi(value.c_str());
+            else if(arg == "--time")
+                options.seconds = atof(value.c_str());
+            else if(arg == "--increment")
+                options.incrementSeconds = atof(value.c_str());
+            else if(arg == "--byoyomi")
+                options.periodSeconds = atof(value.c_str());
+            else if(arg == "--periods")
+                options.numPeriods = strtoul(value.c_str(), nullptr, 10);
+            else if(arg == "--opponent")
+                options.opponent = value;
+            else if(arg == "--color")
+                options.engineColor = value == "black" ? BLACK : WHITE;
+            else if(arg == "--moves")
+                options.moves = value;
+            else if(arg == "--node")
+                options.engine.node = value;
+            else if(arg == "--scheduler")
+                options.engine.scheduler = value;
+            else if(arg == "--search-budget")
+                options.engine.searchBudget = strtoul(value.c_str(), nullptr, 10);
+            else if(arg == "--budget")
+                options.engine.budget = strtoul(value.c_str(), nullptr, 10);
+            else if(arg == "--threads")
+                options.engine.numThreads = strtoul(value.c_str(), nullptr, 10);
+            else if(arg == "--seed")
+                Rng::setSeed(strtoull(value.c_str(), nullptr, 10));
+            else
+                PriorCache::setDirectory(value);
+        }
+        else if(arg == "--recycling")
+            options.engine.recycling = true;
+        else if(arg == "--root-parallel")
+            options.engine.rootParallel = true;
+        else if(arg == "--batch-rollouts")
+            options.engine.batchRollouts = true;
+        else if(arg == "--ponder")
+            options.engine.ponder = true;
+        else
+            return false;
+    }
+    return options.boardSize >= 2 and options.seconds >= 0 and options.incrementSeconds >= 0 and
+           options.periodSeconds >= 0 and (options.seconds > 0 or options.periodSeconds * options.numPeriods > 0) and
+           options.engine.numThreads >= 1 and
+           (options.opponent == "random" or options.opponent == "engine") and
+           (options.engine.node == "UCT-2" or options.engine.node == "MCRAVE") and
+           (options.engine.scheduler == "stop" or options.engine.scheduler == "even" or
+            options.engine.scheduler == "playouts" or options.engine.scheduler == "nodes") and
+           options.engine.searchBudget > 0;
+}
+
+static TimeControl timeControl(const CliOptions& options)
+{
+    TimeControl control;
+    control.mainMsecs = options.seconds * 1000;
+    control.incrementMsecs = options.incrementSeconds * 1000;
+    control.periodMsecs = options.periodSeconds * 1000;
+    control.numPeriods = options.periodSeconds > 0 ? options.numPeriods : 0;
+    return control;
+}
+
+static long int msecsSince(chrono::steady_clock::time_point startTime)
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+// ---- commands ----
+
+static const char* colorName(Color color)
+{
+    return color == WHITE ? "white" : color == BLACK ? "black" : "none";
+}
+
+// the moves of --moves played on the state and passed to the player, false if a move is invalid
+static bool playMoves(const string& moves, Player& player)
+{
+    stringstream stream(moves);
+    string item;
+    while(getline(stream, item, ',')){
+        char* end;
+        unsigned long int cellIdx = strtoul(item.c_str(), &end, 10);
+        if(item.empty() or *end != 0 or cellIdx >= player.state.cellNum or player.state.end() or
+           player.state.cellColor(cellIdx) != EMPTY)
+            return false;
+        unsigned int moveIdx = player.state.toMoveIdx(cellIdx, player.state.getCurrentColor());
+        player.state.update(moveIdx);
+        player.update(moveIdx);
+    }
+    return true;
+}
+
+static int play(const CliOptions& options)
+{
+    unique_ptr<Player> players[2];
+    Color randomColor = options.engineColor == WHITE ? BLACK : WHITE;
+    players[options.engineColor] = make_unique<EnginePlayer>(options.boardSize, options.engine);
+    if(options.opponent == "random")
+        players[randomColor] = make_unique<RandomPlayer>(options.boardSize);
+    else
+        players[randomColor] = make_unique<EnginePlayer>(options.boardSize, options.engine);
+    GameState referee{options.boardSize, GameState::FreeNeighbours};
+    for(auto& player : players){
+        player->setup();
+        player->clock.reset(timeControl(options));
+    }
+    printf("board size: %d\nwhite: %s\nblack: %s\n", options.boardSize, players[WHITE]->name(), players[BLACK]->name());
+    unsigned int turn = 1;
+    while(!referee.end()){
+        Color color = referee.getCurrentPlayer();
+        Player& player = *players[color];
+        Player& opponent = *players[color == WHITE ? BLACK : WHITE];
+        unsigned int numTaken = player.state.numTakenMoves();
+        auto startTime = chrono::steady_clock::now();
+        player.clock.start();
+        player.selectBestMoves();
+        player.clock.stop();
+        if(player.clock.remaining() < 0){
+            printf("%s lost on time\nwinner: %s\n", colorName(color), colorName(color == WHITE ? BLACK : WHITE));
+            return 0;
+        }
+        printf("turn %u: %s plays", turn++, colorName(color));
+        for(unsigned int i = numTaken; i < player.state.numTakenMoves(); ++i){
+            unsigned int moveIdx = player.state.takenMove(i);
+            printf(" %s %u", colorName(static_cast<Color>(moveIdx / referee.cellNum)), moveIdx % referee.cellNum);
+            referee.update(moveIdx);
+            opponent.state.update(moveIdx);
+            opponent.update(moveIdx);
+        }
+        if(player.ponderedPlayouts() > 0)
+            printf(" (%ld ms, %lu pondered playouts)\n", msecsSince(startTime), player.ponderedPlayouts());
+        else
+            printf(" (%ld ms)\n", msecsSince(startTime));
+    }
+    map<Color, double> scores = referee.getPlayerScores();
+    printf("score: white %.0f black %.0f\nwinner: %s\n", scores[WHITE], scores[BLACK], colorName(referee.leader()));
+    return 0;
+}
+
+static int analyse(const CliOptions& options)
+{
+    EnginePlayer player{options.boardSize, options.engine};
+    // the initial policy is computed on the empty board
+    player.setup();
+    if(!playMoves(options.moves, player)){
+        fprintf(stderr, "invalid move in --moves\n");
+        return 1;
+    }
+    if(player.state.end()){
+        fprintf(stderr, "the game is over\n");
+        return 1;
+    }
+    player.clock.reset(timeControl(options));
+    unsigned int numTaken = player.state.numTakenMoves();
+    auto startTime = chrono::steady_clock::now();
+    player.clock.start();
+    player.selectBestMoves();
+    player.clock.stop();
+    printf("player: %s\nmoves:", colorName(player.state.getPreviousPlayer()));
+    for(unsigned int i = numTaken; i < player.state.numTakenMoves(); ++i){
+        unsigned int moveIdx = player.state.takenMove(i);
+        printf(" %s %u", colorName(static_cast<Color>(moveIdx / player.state.cellNum)), moveIdx % player.state.cellNum);
+    }
+    printf("\ntime: %ld ms\n", msecsSince(startTime));
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    CliOptions options;
+    if(argc > 1 and string(argv[1]) == "--help"){
+        printUsage();
+        return 0;
+    }
+    if(!parseArgs(argc, argv, options)){
+        printUsage();
+        return 2;
+    }
+    if(options.command == "analyse")
+        return analyse(options);
+    return play(options);
+}
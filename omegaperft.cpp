@@ -0,0 +1,349 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bitgamestate.h"
+#include "gamestate.h"
+#include "rng.h"
+
+using namespace std;
+
+// ---- options ----
+
+struct PerftOptions{
+    int boardSize = 4;
+    unsigned int depth = 3;
+    // cells of the moves played before the enumeration, the colors alternate from white
+    string moves;
+    // random full games played from the position instead of the enumeration
+    unsigned int numGames = 0;
+    bool bitboard = false;
+    bool check = true;
+    bool divide = false;
+};
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "usage: omega-perft [options]\n"
+            "  counts the move sequences from a position for each depth up to --depth, a move places one piece\n"
+            "  --size N              board size (default 4)\n"
+            "  --depth D             number of pieces placed (default 3)\n"
+            "  --moves C,C,...       cells of the moves already played, the colors alternate from white\n"
+            "  --games N             plays N random games from the position to the end instead, checked the same way\n"
+            "  --bitboard            enumerate and play the games on BitGameState instead of GameState\n"
+            "  --no-check            only count, without recomputing the groups of every position\n"
+            "  --divide              counts of the last depth for each move of the position\n");
+}
+
+static bool parseArgs(int argc, char** argv, PerftOptions& options)
+{
+    for(int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if(arg == "--bitboard")
+            options.bitboard = true;
+        else if(arg == "--no-check")
+            options.check = false;
+        else if(arg == "--divide")
+            options.divide = true;
+        else if(i + 1 < argc and (arg == "--size" or arg == "--depth" or arg == "--moves" or arg == "--games")){
+            string value = argv[++i];
+            if(arg == "--size")
+                options.boardSize = atoi(value.c_str());
+            else if(arg == "--depth")
+                options.depth = strtoul(value.c_str(), nullptr, 10);
+            else if(arg == "--games")
+                options.numGames = strtoul(value.c_str(), nullptr, 10);
+            else
+                options.moves = value;
+        }
+        else
+            return false;
+    }
+    return options.boardSize >= 2 and options.depth >= 1 and (!options.bitboard or options.boardSize <= BitGameState::maxBoardSize);
+}
+
+// ---- enumeration ----
+
+template<typename StateType>
+class Perft
+/*
+ * counts the positions reached from the current one by every sequence of moves with update() and undo(). With
+ * checking, the groups of each position are recomputed by a flood fill and compared with the incremental group sizes
+ * and scores of the state, after each update and after each undo. An undo also has to restore the cell colors. The
+ * outcome is compared with the exact products of the group sizes, which overflow every integer type on large boards:
+ * random full games check the scores where the enumeration can not reach.
+ */
+{
+public:
+    Perft(StateType* state, bool check):
+        numPositions{0},
+        numErrors{0},
+        state{state},
+        check{check},
+        neighbours(state->cellNum),
+        visited(state->cellNum),
+        colors(state->cellNum + 1, vector<Color>(state->cellNum)),
+        exactProducts{vector<uint32_t>(state->cellNum / 32 + 2), vector<uint32_t>(state->cellNum / 32 + 2)}
+    {
+        for(unsigned int cellIdx = 0; cellIdx < state->cellNum; ++cellIdx)
+            neighbours[cellIdx] = state->neighbourIdxs(cellIdx);
+        stack.reserve(state->cellNum);
+        group.reserve(state->cellNum);
+        // a game has at most one move per cell
+        moves.resize(state->cellNum + 1);
+        for(vector<unsigned int>& plyMoves : moves)
+            plyMoves.reserve(state->moveNum());
+        if(check)
+            verify();
+    }
+
+    // number of sequences of depth moves, a sequence that ends the game earlier counts once
+    unsigned long int run(unsigned int depth){
+        return count(depth, 0);
+    }
+
+    // the moves of the position with the number of sequences that start with each of them
+    vector<pair<unsigned int, unsigned long int>> divide(unsigned int depth){
+        vector<pair<unsigned int, unsigned long int>> counts;
+        for(unsigned int moveIdx : state->validMoves)
+            counts.push_back({moveIdx, 0});
+        for(auto& moveCount : counts){
+            play(moveCount.first, 0);
+            moveCount.second = count(depth - 1, 1);
+            takeBack(0);
+        }
+        return counts;
+    }
+
+    // plays numGames games of uniformly random moves to the end and takes them back, returns the number of moves
+    unsigned long int playGames(unsigned int numGames, Rng& rng){
+        unsigned long int numMoves = 0;
+        for(unsigned int game = 0; game < numGames; ++game){
+            unsigned int ply = 0;
+            while(!state->end()){
+                auto it = state->validMoves.begin();
+                for(unsigned int n = rng.below(state->validMoves.size()); n > 0; --n)
+                    ++it;
+                play(*it, ply++);
+            }
+            numMoves += ply;
+            while(ply > 0)
+                takeBack(--ply);
+        }
+        return numMoves;
+    }
+
+    // positions reached by an update
+    unsigned long int numPositions;
+    unsigned long int numErrors;
+
+private:
+    unsigned long int count(unsigned int depth, unsigned int ply){
+        if(depth == 0 or state->end())
+            return 1;
+        vector<unsigned int>& plyMoves = moves[ply];
+        plyMoves.clear();
+        for(unsigned int moveIdx : state->validMoves)
+            plyMoves.push_back(moveIdx);
+        unsigned long int numLeaves = 0;
+        for(unsigned int moveIdx : plyMoves){
+            play(moveIdx, ply);
+            numLeaves += count(depth - 1, ply + 1);
+            takeBack(ply);
+        }
+        return numLeaves;
+    }
+
+    void play(unsigned int moveIdx, unsigned int ply){
+        if(check){
+            for(unsigned int cellIdx = 0; cellIdx < state->cellNum; ++cellIdx)
+                colors[ply][cellIdx] = state->cellColor(cellIdx);
+        }
+        state->update(moveIdx);
+        ++numPositions;
+        if(check)
+            verify();
+    }
+
+    void takeBack(unsigned int ply){
+        state->undo();
+        if(!check)
+            return;
+        for(unsigned int cellIdx = 0; cellIdx < state->cellNum; ++cellIdx){
+            if(state->cellColor(cellIdx) != colors[ply][cellIdx]){
+                report("the color of a cell is not restored by undo");
+                break;
+            }
+        }
+        verify();
+    }
+
+    // the groups of the position by flood fill against the state
+    void verify(){
+        long double products[2] = {1, 1};
+        for(vector<uint32_t>& product : exactProducts){
+            fill(product.begin(), product.end(), 0);
+            product[0] = 1;
+        }
+        unsigned int numGroups[2] = {0, 0};
+        fill(visited.begin(), visited.end(), false);
+        for(unsigned int cellIdx = 0; cellIdx < state->cellNum; ++cellIdx){
+            Color color = state->cellColor(cellIdx);
+            if(color == EMPTY or visited[cellIdx])
+                continue;
+            group.clear();
+            stack.push_back(cellIdx);
+            visited[cellIdx] = true;
+            while(!stack.empty()){
+                unsigned int idx = stack.back();
+                stack.pop_back();
+                group.push_back(idx);
+                for(unsigned int nIdx : neighbours[idx]){
+                    if(!visited[nIdx] and state->cellColor(nIdx) == color){
+                        visited[nIdx] = true;
+                        stack.push_back(nIdx);
+                    }
+                }
+            }
+            for(unsigned int idx : group){
+                if(state->groupSize(idx) != group.size()){
+                    report("group size");
+                    break;
+                }
+            }
+            products[color] *= group.size();
+            multiply(exactProducts[color], group.size());
+            ++numGroups[color];
+        }
+        map<Color, double> scores = state->getPlayerScores();
+        long double expected[2];
+        for(unsigned int color = WHITE; color <= BLACK; ++color){
+            expected[color] = numGroups[color] > 0 ? products[color] : 0;
+            // the scores are rounded exponentials of fixed point logarithm sums
+            if(fabsl(scores[static_cast<Color>(color)] - expected[color]) > 1e-9L * expected[color] + 0.5L)
+                report("player score");
+        }
+        // a color without stones scores 0, the exact products are 1 then
+        int order = (numGroups[WHITE] > 0) - (numGroups[BLACK] > 0);
+        if(numGroups[WHITE] > 0 and numGroups[BLACK] > 0)
+            order = compare(exactProducts[WHITE], exactProducts[BLACK]);
+        if(state->getScore() != (order > 0 ? 1 : order < 0 ? 0 : 0.5))
+            report("outcome");
+    }
+
+    // little endian base 2^32 digits, large enough for the product of the group sizes of a full board
+    static void multiply(vector<uint32_t>& product, unsigned int factor){
+        uint64_t carry = 0;
+        for(uint32_t& digit : product){
+            uint64_t value = static_cast<uint64_t>(digit) * factor + carry;
+            digit = static_cast<uint32_t>(value);
+            carry = value >> 32;
+        }
+    }
+
+    static int compare(const vector<uint32_t>& first, const vector<uint32_t>& second){
+        for(size_t i = first.size(); i-- > 0;){
+            if(first[i] != second[i])
+                return first[i] > second[i] ? 1 : -1;
+        }
+        return 0;
+    }
+
+    void report(const char* what){
+        // the first errors are enough to find the move sequence
+        if(numErrors++ >= 10)
+            return;
+        fprintf(stderr, "error: %s after the moves", what);
+        for(unsigned int i = 0; i < state->numTakenMoves(); ++i)
+            fprintf(stderr, " %u", state->takenMove(i));
+        fprintf(stderr, "\n");
+    }
+
+    StateType* state;
+    const bool check;
+    // moves of each ply, reserved so the enumeration does not allocate
+    vector<vector<unsigned int>> moves;
+    // buffers of the flood fill
+    vector<vector<unsigned int>> neighbours;
+    vector<bool> visited;
+    vector<unsigned int> stack;
+    vector<unsigned int> group;
+    // cell colors before the move of each ply
+    vector<vector<Color>> colors;
+    // exact scores of the verified position
+    vector<uint32_t> exactProducts[2];
+};
+
+template<typename StateType>
+static int perft(StateType& state, const PerftOptions& options)
+{
+    stringstream stream(options.moves);
+    string item;
+    while(getline(stream, item, ',')){
+        char* end;
+        unsigned long int cellIdx = strtoul(item.c_str(), &end, 10);
+        if(item.empty() or *end != 0 or cellIdx >= state.cellNum or state.end() or state.cellColor(cellIdx) != EMPTY){
+            fprintf(stderr, "invalid move in --moves\n");
+            return 2;
+        }
+        state.update(state.toMoveIdx(cellIdx, state.getCurrentColor()));
+    }
+    Perft<StateType> perft{&state, options.check};
+    printf("board size: %d\nstate: %s\ncheck: %s\n", options.boardSize, options.bitboard ? "BitGameState" : "GameState",
+           options.check ? "yes" : "no");
+    if(options.numGames > 0){
+        Rng rng{Rng::PerftStream};
+        auto startTime = chrono::steady_clock::now();
+        unsigned long int numMoves = perft.playGames(options.numGames, rng);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        printf("games %u: %lu moves, %.3f s, %.0f positions/s\n", options.numGames, numMoves, secs,
+               perft.numPositions / max(secs, 1e-9));
+    }
+    for(unsigned int depth = 1; options.numGames == 0 and depth <= options.depth; ++depth){
+        unsigned long int numPositions = perft.numPositions;
+        auto startTime = chrono::steady_clock::now();
+        unsigned long int numLeaves = perft.run(depth);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        numPositions = perft.numPositions - numPositions;
+        printf("depth %u: %lu sequences, %lu positions, %.3f s, %.0f positions/s\n", depth, numLeaves, numPositions,
+               secs, numPositions / max(secs, 1e-9));
+        fflush(stdout);
+    }
+    if(options.divide and options.numGames == 0){
+        for(auto& moveCount : perft.divide(options.depth)){
+            unsigned int cellIdx = moveCount.first % state.cellNum;
+            printf("%s %u: %lu\n", moveCount.first < state.cellNum ? "white" : "black", cellIdx, moveCount.second);
+        }
+    }
+    if(perft.numErrors > 0){
+        printf("errors: %lu\n", perft.numErrors);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    PerftOptions options;
+    if(argc > 1 and string(argv[1]) == "--help"){
+        printUsage();
+        return 0;
+    }
+    if(!parseArgs(argc, argv, options)){
+        printUsage();
+        return 2;
+    }
+    if(options.bitboard){
+        BitGameState state{options.boardSize};
+        return perft(state, options);
+    }
+    GameState state{options.boardSize, GameState::FreeNeighbours};
+    return perft(state, options);
+}
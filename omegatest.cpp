@@ -0,0 +1,93 @@
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bitgamestate.h"
+#include "gamestate.h"
+#include "hmcravenode.h"
+
+using namespace std;
+
+// ---- cases ----
+
+// the AMAF values are internal to the node
+struct RAVETest: RAVENode{
+    using RAVENode::AMAF;
+};
+
+static bool checkAMAF(double prior, const function<double(unsigned int)>& sample)
+{
+    const unsigned int numUpdates = 100000;
+    RAVETest::AMAF amaf{0, 0};
+    amaf.seed(prior);
+    // the seed counts as the first sample
+    double sum = prior;
+    for(unsigned int i = 0; i < numUpdates; ++i){
+        double val = sample(i);
+        amaf.update(val);
+        sum += val;
+    }
+    double expected = sum / (numUpdates + 1);
+    if(amaf.count != numUpdates + 1 or fabs(amaf.value() - expected) > 1e-4){
+        fprintf(stderr, "amaf: mean %.6f after %u updates, expected %.6f\n", amaf.value(), amaf.count, expected);
+        return false;
+    }
+    return true;
+}
+
+static bool testAMAF()
+{
+    // one win in three, a constant outcome and a long run of losses followed by wins
+    return checkAMAF(0.5, [](unsigned int i){ return i % 3 == 0 ? 1.0 : 0.0; })
+       and checkAMAF(0.0, [](unsigned int){ return 1.0; })
+       and checkAMAF(1.0, [](unsigned int i){ return i < 90000 ? 0.0 : 1.0; });
+}
+
+// the prior of a seed is the same for any number of workers
+template<typename StateType>
+static bool checkPrior(StateType state, const char* name)
+{
+    array<vector<double>, 2> single = state.getInitialPolicy(42, 1);
+    array<vector<double>, 2> parallel = state.getInitialPolicy(42, 3);
+    if(single != parallel){
+        fprintf(stderr, "prior: the scores of %s differ between 1 and 3 workers\n", name);
+        return false;
+    }
+    return true;
+}
+
+static bool testPrior()
+{
+    return checkPrior(GameState{4, GameState::FreeNeighbours}, "GameState") and checkPrior(BitGameState{4}, "BitGameState");
+}
+
+struct TestCase{
+    string name;
+    function<bool()> run;
+};
+
+static const vector<TestCase> testCases{
+    {"amaf", testAMAF},
+    {"prior", testPrior},
+};
+
+// ---- main ----
+
+int main(int argc, char** argv)
+{
+    // every case without argument, otherwise the named ones
+    unsigned int numFailed = 0;
+    for(const TestCase& testCase : testCases){
+        bool selected = argc == 1;
+        for(int i = 1; i < argc; ++i)
+            selected = selected or testCase.name == argv[i];
+        if(!selected)
+            continue;
+        bool passed = testCase.run();
+        printf("%s %s\n", testCase.name.c_str(), passed ? "passed" : "FAILED");
+        numFailed += !passed;
+    }
+    return numFailed ? 1 : 0;
+}
@@ -0,0 +1,378 @@
+#ifndef PARALLELMCTS_H
+#define PARALLELMCTS_H
+
+#include "mcts.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template<typename NodeType, typename PolicyType=MAST, typename SchedulerType=StopScheduler<NodeType>>
+class TreeParallelMCTS: public MCTS<NodeType, PolicyType, SchedulerType>
+/*
+ * tree parallelization: numThreads workers descend the shared transposition table, each with its own copy of the game
+ * state, the policy and the zobrist cursor. A node is selected, visited and backpropagated under the lock of its
+ * stripe, the statistics the parents read are relaxed atomics. Storing and removing nodes takes the table lock, the
+ * probes take none. Virtual loss spreads the workers over different branches. Each playout is granted by the
+ * scheduler before its selection, so a playout budget is exact.
+ */
+{
+    typedef MCTS<NodeType, PolicyType, SchedulerType> Base;
+    // recycling moves nodes in and out of a global fifo during selection, which would need a lock on every step
+    static_assert(!ZHashTable<NodeType>::isRecycledType, "tree parallelization is not supported with node recycling");
+public:
+    TreeParallelMCTS(ZHashTable<NodeType>* tTable, GameState* gameState, PolicyType* policy, SchedulerType* scheduler, unsigned int numThreads):
+        Base(tTable, gameState, policy, scheduler),
+        master{this},
+        numThreads{numThreads}
+    {}
+
+    virtual ~TreeParallelMCTS()=default;
+
+    virtual void run() override{
+        this->bind();
+        this->scheduler->schedule();
+        stop = false;
+        numPlayouts = 0;
+        ALLOC_AUDIT_BEGIN();
+        // workers are set up on this thread, the game state copies are not safe to construct concurrently
+        vector<unique_ptr<GameState>> gameStates;
+        vector<unique_ptr<PolicyType>> policies;
+        vector<unique_ptr<ZHashTable<NodeType>>> views;
+        vector<unique_ptr<TreeParallelMCTS>> workers;
+        for(unsigned int i = 0; i < numThreads; ++i){
+            gameStates.push_back(make_unique<GameState>(*this->gameState));
+            policies.push_back(make_unique<PolicyType>(*this->policy, gameStates.back().get(), i+1));
+            views.push_back(make_unique<ZHashTable<NodeType>>(this->tTable, gameStates.back().get(), policies.back().get()));
+            workers.push_back(unique_ptr<TreeParallelMCTS>(new TreeParallelMCTS(this, views.back().get(), gameStates.back().get(), policies.back().get())));
+        }
+        vector<thread> threads;
+        threads.reserve(numThreads);
+        for(auto& worker : workers)
+            threads.emplace_back(&TreeParallelMCTS::search, worker.get());
+        for(auto& t : threads)
+            t.join();
+        // replaced nodes could be on the path of other workers so they are only deallocated here
+        this->bind();
+        for(NodeType* node : retired){
+            this->tTable->context.rNode = node;
+            Node<NodeType>::manageMemory();
+        }
+        retired.clear();
+        ALLOC_AUDIT_END(numPlayouts);
+        this->playBestMoves();
+    }
+
+    // number of playouts of the last search over all threads
+    unsigned long int playouts() const{
+        return numPlayouts;
+    }
+
+protected:
+    // worker constructor
+    TreeParallelMCTS(TreeParallelMCTS* master, ZHashTable<NodeType>* tTable, GameState* gameState, PolicyType* policy):
+        Base(tTable, gameState, policy, master->scheduler),
+        master{master},
+        numThreads{1}
+    {
+        // the workers descend from the root of the master
+        this->root = this->currNode = master->root;
+    }
+
+    void search(){
+        this->bind();
+        while(grant()){
+            selection();
+            double outcome = simulation();
+            backpropagation(outcome);
+        }
+    }
+
+    // asks the scheduler for one more playout, the playouts are only counted once they are granted
+    bool grant(){
+        lock_guard<mutex> lock(master->schedulerMutex);
+        if(master->stop)
+            return false;
+        // the stop scheduler resolves the children of the root
+        lock_guard<mutex> rootLock(master->nodeMutex(this->root));
+        if(this->scheduler->finish()){
+            master->stop = true;
+            return false;
+        }
+        ++master->numPlayouts;
+        return true;
+    }
+
+    // lock of the stripe of the node, the keys are uniformly distributed
+    mutex& nodeMutex(const NodeType* node){
+        return stripes[node->key % numStripes].lock;
+    }
+
+    void selection(){
+        // same as MCTS::selection but each node is visited under its lock and the leaf is stored under the table lock
+        ALLOC_AUDIT_SCOPE(Selection);
+        this->currPlayer = this->gameState->getCurrentPlayer();
+        this->currNode = this->root;
+        NodeType* child;
+        {
+            lock_guard<mutex> lock(master->nodeMutex(this->root));
+            child = this->root->select();
+        }
+        ++this->tTable->context.currDepth;
+        this->policy->addMove(this->currPlayer, this->gameState->takenMove());
+        while(!this->gameState->end() and child){
+            this->currNode = child;
+            this->path.push(this->currNode);
+            this->currPlayer = this->gameState->getCurrentPlayer();
+            {
+                lock_guard<mutex> lock(master->nodeMutex(this->currNode));
+                this->currNode->addVirtualLoss();
+                child = this->currNode->select();
+            }
+            ++this->tTable->context.currDepth;
+            this->policy->addMove(this->currPlayer, this->gameState->takenMove());
+        }
+        if(!this->gameState->end()){
+            ALLOC_AUDIT_SCOPE(Expansion);
+            {
+                lock_guard<mutex> lock(master->tableMutex);
+                // another worker could have stored the position since the selection of its parent
+                NodeType* leaf = this->tTable->load();
+                this->currNode = leaf ? leaf : this->currNode->expand();
+                if(this->tTable->context.rNode){
+                    master->retired.push_back(this->tTable->context.rNode);
+                    this->tTable->context.rNode = nullptr;
+                }
+            }
+            this->path.push(this->currNode);
+            unsigned int moveIdx = this->policy->select();
+            {
+                lock_guard<mutex> lock(master->nodeMutex(this->currNode));
+                this->currNode->addVirtualLoss();
+                this->currNode->updateLeaf(moveIdx);
+            }
+            this->tTable->update(moveIdx);
+            this->currPlayer = this->gameState->getCurrentPlayer();
+            this->gameState->update(moveIdx);
+            this->currNode = this->tTable->load();
+        }
+    }
+
+    double simulation(){
+        // same as MCTS::simulation but the table is probed after each move, the statistics of a hit are relaxed atomics
+        ALLOC_AUDIT_SCOPE(Simulation);
+        double outcome;
+        unsigned int numSim = 1;
+        while(true){
+            if(this->gameState->end()){
+                outcome = this->gameState->getScore();
+                this->policy->addMove(this->currPlayer, this->gameState->takenMove());
+                break;
+            }
+            if(numSim > 1)
+                this->currNode = this->tTable->load();
+            if(this->currNode){
+                outcome = this->currNode->stateScore();
+                outcome = outcome + this->currPlayer * (1-2*outcome);
+                break;
+            }
+            // the watchdog ended the round, the cut playout is discarded
+            if(this->scheduler->aborted()){
+                outcome = Base::cutOutcome;
+                break;
+            }
+            unsigned int moveIdx = this->policy->select();
+            this->policy->addMove(this->currPlayer, this->gameState->takenMove());
+            this->currPlayer = this->gameState->getCurrentPlayer();
+            this->tTable->update(moveIdx);
+            this->gameState->update(moveIdx);
+            ++numSim;
+        }
+        if(outcome == Base::cutOutcome)
+            this->policy->discard();
+        else
+            this->policy->update(outcome);
+        while(numSim > 0){
+            this->root->backward();
+            --numSim;
+        }
+        return outcome;
+    }
+
+    void backpropagation(double outcome){
+        // same as MCTS::backpropagation and MCTS::discard with the lock of each node, nodes are only deallocated by run()
+        ALLOC_AUDIT_SCOPE(Backpropagation);
+        bool cut = outcome == Base::cutOutcome;
+        while(!this->path.empty()){
+            NodeType* node = this->path.top();
+            {
+                lock_guard<mutex> lock(master->nodeMutex(node));
+                node->removeVirtualLoss();
+                if(cut)
+                    node->backward();
+                else
+                    node->backprop(outcome);
+            }
+            this->path.pop();
+            --this->tTable->context.currDepth;
+        }
+        if(cut){
+            this->tTable->context.data = {};
+            return;
+        }
+        lock_guard<mutex> lock(master->nodeMutex(this->root));
+        this->root->backpropRoot(outcome);
+    }
+
+    static constexpr unsigned int numStripes = 64;
+    struct alignas(64) Stripe{
+        mutex lock;
+    };
+
+    TreeParallelMCTS* master;
+    const unsigned int numThreads;
+    // shared by the workers through master. Lock order: scheduler, then one node. The table lock is taken alone.
+    Stripe stripes[numStripes];
+    mutex tableMutex;
+    mutex schedulerMutex;
+    bool stop;
+    unsigned long int numPlayouts;
+    vector<NodeType*> retired;
+};
+
+template<typename NodeType, typename PolicyType=MAST, typename SchedulerType=StopScheduler<NodeType>>
+class RootParallelMCTS: public MCTS<NodeType, PolicyType, SchedulerType>
+/*
+ * root parallelization: numSearchers independent searches, each with its own game state, policy and transposition
+ * table, run for the same time budget. This instance is the first searcher and its scheduler stops the others. Moves
+ * are selected by the root child visit counts summed over the searchers.
+ */
+{
+    typedef MCTS<NodeType, PolicyType, SchedulerType> Base;
+public:
+    RootParallelMCTS(ZHashTable<NodeType>* tTable, GameState* gameState, PolicyType* policy, SchedulerType* scheduler, unsigned int numSearchers):
+        Base(tTable, gameState, policy, scheduler),
+        master{this},
+        numSearchers{numSearchers}
+    {}
+
+    virtual ~RootParallelMCTS()=default;
+
+    virtual void reset() override{
+        Base::reset();
+        // the other searchers are rebuilt from the reset game state, the policy copies reuse the computed initial scores
+        helpers.clear();
+        tTables.clear();
+        policies.clear();
+        gameStates.clear();
+        for(unsigned int i = 1; i < numSearchers; ++i){
+            gameStates.push_back(make_unique<GameState>(*this->gameState));
+            policies.push_back(make_unique<PolicyType>(*this->policy, gameStates.back().get(), i));
+            tTables.push_back(make_unique<ZHashTable<NodeType>>(gameStates.back().get(), policies.back().get(), this->tTable->LenHashCode, this->tTable->budget));
+            helpers.push_back(unique_ptr<RootParallelMCTS>(new RootParallelMCTS(this, tTables.back().get(), gameStates.back().get(), policies.back().get())));
+        }
+    }
+
+    virtual void updateRoot(unsigned int moveIdx) override{
+        // gameState is expected to be updated, the copies of the other searchers are not
+        Base::updateRoot(moveIdx);
+        for(auto& helper : helpers){
+            helper->gameState->update(moveIdx);
+            helper->updateRoot(moveIdx);
+        }
+    }
+
+    virtual void run() override{
+        this->bind();
+        this->scheduler->schedule();
+        stop = false;
+        ALLOC_AUDIT_BEGIN();
+        vector<thread> threads;
+        threads.reserve(helpers.size());
+        for(auto& helper : helpers)
+            threads.emplace_back(&RootParallelMCTS::search, helper.get());
+        numPlayouts = 0;
+        while(!this->scheduler->finish()){
+            this->selection();
+            double outcome = this->simulation();
+            this->backpropagation(outcome);
+            ++numPlayouts;
+        }
+        stop = true;
+        for(auto& t : threads)
+            t.join();
+        ALLOC_AUDIT_END(playouts());
+        Color rootPlayer = this->gameState->getCurrentPlayer();
+        do{
+            unsigned int moveIdx = selectMostVisited();
+            this->gameState->update(moveIdx);
+            updateRoot(moveIdx);
+        }while(rootPlayer == this->gameState->getCurrentPlayer());
+    }
+
+    // number of playouts of the last search over all searchers
+    unsigned long int playouts() const{
+        unsigned long int sum = numPlayouts;
+        for(auto& helper : helpers)
+            sum += helper->numPlayouts;
+        return sum;
+    }
+
+protected:
+    // helper searcher constructor
+    RootParallelMCTS(RootParallelMCTS* master, ZHashTable<NodeType>* tTable, GameState* gameState, PolicyType* policy):
+        Base(tTable, gameState, policy, master->scheduler),
+        master{master},
+        numSearchers{1}
+    {}
+
+    void search(){
+        this->bind();
+        numPlayouts = 0;
+        while(!master->stop){
+            this->selection();
+            double outcome = this->simulation();
+            this->backpropagation(outcome);
+            ++numPlayouts;
+        }
+    }
+
+    unsigned int selectMostVisited(){
+        // the search only runs before the end of the game
+        assertm(this->gameState->validMoves.size() > 0, "the root should have a valid move");
+        double maxVisit = -1;
+        unsigned int bestMoveIdx = *this->gameState->validMoves.begin();
+        for(unsigned int moveIdx : this->gameState->validMoves){
+            double visit = childVisitCount(moveIdx);
+            for(auto& helper : helpers)
+                visit += helper->childVisitCount(moveIdx);
+            if(visit > maxVisit){
+                maxVisit = visit;
+                bestMoveIdx = moveIdx;
+            }
+        }
+        return bestMoveIdx;
+    }
+
+    double childVisitCount(unsigned int moveIdx){
+        this->tTable->update(moveIdx);
+        NodeType* child = this->tTable->load();
+        // xor twice with the same value gives back the original
+        this->tTable->update(moveIdx);
+        return child ? child->visitCount() : 0;
+    }
+
+    RootParallelMCTS* master;
+    const unsigned int numSearchers;
+    atomic<bool> stop;
+    unsigned long int numPlayouts;
+    // the other searchers and their state, helpers are declared last so they are destroyed first
+    vector<unique_ptr<GameState>> gameStates;
+    vector<unique_ptr<PolicyType>> policies;
+    vector<unique_ptr<ZHashTable<NodeType>>> tTables;
+    vector<unique_ptr<RootParallelMCTS>> helpers;
+};
+
+#endif // PARALLELMCTS_H
@@ -0,0 +1,100 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include "engine.h"
+#include "gameclock.h"
+#include "gamestate.h"
+#include "rng.h"
+
+class Player
+/*
+ * a side of the game with its own copy of the game state and its own clock. A player plays its moves on its state,
+ * the moves of the opponent are passed to update() after they are played on the state.
+ */
+{
+public:
+    explicit Player(int boardSize):
+        state{boardSize, GameState::FreeNeighbours}
+    {}
+    virtual ~Player()=default;
+    virtual void setup() {}
+    // a new game from the empty board
+    virtual void reset(){
+        state.reset();
+    }
+    virtual void update(unsigned int) {}
+    virtual void selectBestMoves()=0;
+    virtual const char* name() const=0;
+    // playouts searched during the last turn of the opponent
+    virtual unsigned long int ponderedPlayouts() const{
+        return 0;
+    }
+
+    GameState state;
+    GameClock clock;
+};
+
+class EnginePlayer: public Player
+{
+public:
+    EnginePlayer(int boardSize, const EngineOptions& options):
+        Player(boardSize),
+        engine{&state, &clock, options}
+    {}
+
+    void setup() override{
+        engine.setup();
+    }
+
+    void reset() override{
+        Player::reset();
+        engine.reset();
+    }
+
+    void update(unsigned int moveIdx) override{
+        engine.update(moveIdx);
+    }
+
+    void selectBestMoves() override{
+        engine.selectBestMoves();
+    }
+
+    const char* name() const override{
+        return "engine";
+    }
+
+    unsigned long int ponderedPlayouts() const override{
+        return engine.ponderedPlayouts();
+    }
+
+private:
+    Engine engine;
+};
+
+class RandomPlayer: public Player
+{
+public:
+    explicit RandomPlayer(int boardSize):
+        Player(boardSize),
+        rng{Rng::OpponentStream}
+    {}
+
+    void selectBestMoves() override{
+        Color rootPlayer = state.getCurrentPlayer();
+        do{
+            auto it = state.validMoves.begin();
+            for(unsigned int n = rng.below(state.validMoves.size()); n > 0; --n)
+                ++it;
+            state.update(*it);
+        }while(!state.end() and state.getCurrentPlayer() == rootPlayer);
+    }
+
+    const char* name() const override{
+        return "random";
+    }
+
+private:
+    Rng rng;
+};
+
+#endif // PLAYER_H
@@ -0,0 +1,39 @@
+#ifndef PLAYOUTBUDGETSCHEDULER_H
+#define PLAYOUTBUDGETSCHEDULER_H
+
+class PlayoutBudgetScheduler
+/*
+ * every search runs the same number of playouts whatever the speed or the load of the machine, so that variants can
+ * be compared at equal work. The game clock is not used. With tree parallelization each playout is granted before its
+ * selection, so the workers run exactly the budget together, with root parallelization the budget is the one of the
+ * first searcher.
+ */
+{
+public:
+    explicit PlayoutBudgetScheduler(unsigned long int numPlayouts):
+        numPlayouts{numPlayouts},
+        count{0}
+    {}
+
+    void schedule(){
+        count = 0;
+    }
+
+    bool finish(){
+        return count++ >= numPlayouts;
+    }
+
+    void reset() {}
+
+    // a playout is never cut short
+    bool aborted() const{
+        return false;
+    }
+
+protected:
+    const unsigned long int numPlayouts;
+    // number of calls to finish() since the start of the search
+    unsigned long int count;
+};
+
+#endif // PLAYOUTBUDGETSCHEDULER_H
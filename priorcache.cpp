@@ -0,0 +1,153 @@
+#include "priorcache.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---- (re-)initializations ----
+
+PriorCache::PriorCache(unsigned int numMoves):
+    numMoves{numMoves},
+    data{nullptr},
+    mapping{nullptr},
+    mappingSize{0}
+{}
+
+PriorCache::~PriorCache()
+{
+    if(mapping)
+        munmap(mapping, mappingSize);
+}
+
+void PriorCache::setDirectory(const string& dir)
+{
+    directory = dir;
+}
+
+string PriorCache::getDirectory()
+{
+    if(!directory.empty())
+        return directory;
+    const char* cacheHome = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if(cacheHome and *cacheHome)
+        return (filesystem::path(cacheHome) / "omega").string();
+    if(home and *home)
+        return (filesystem::path(home) / ".cache" / "omega").string();
+    // a directory of the user in the temporary directory, it is not used if another user created it first
+    error_code error;
+    filesystem::path tmp = filesystem::temp_directory_path(error);
+    return ((error ? filesystem::path(".") : tmp) / ("omega-" + to_string(getuid()))).string();
+}
+
+shared_ptr<const PriorCache> PriorCache::load(GameState* gameState)
+{
+    unsigned int boardSize = gameState->getBoardSize();
+    // the prior has its own stream, the draws of the game state do not depend on the presence of the file
+    uint64_t seed = Rng{Rng::PriorStream}();
+    Header header = {{'O', 'M', 'E', 'G', 'A', 'P', 'R', 'I'}, version, boardSize, gameState->moveNum(),
+                     GameState::numPriorPlayouts, seed};
+    shared_ptr<PriorCache> cache{new PriorCache(gameState->moveNum())};
+    string dir = getDirectory();
+    bool owned = ownDirectory(dir);
+    string file = path(boardSize, seed);
+    if(owned and cache->map(file, header))
+        return cache;
+    array<vector<double>, 2> scores = gameState->getInitialPolicy(seed);
+    if(owned and write(file, header, scores) and cache->map(file, header))
+        return cache;
+    // the directory is not writable or not safe, the prior is only kept by this process
+    fprintf(stderr, "prior cache: %s could not be written\n", file.c_str());
+    cache->owned = scores[WHITE];
+    cache->owned.insert(cache->owned.end(), scores[BLACK].begin(), scores[BLACK].end());
+    cache->data = cache->owned.data();
+    return cache;
+}
+
+// ---- file access ----
+
+string PriorCache::path(unsigned int boardSize, uint64_t seed)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "omega-prior-%u-%016llx.bin", boardSize, static_cast<unsigned long long>(seed));
+    return (filesystem::path(getDirectory()) / name).string();
+}
+
+bool PriorCache::ownDirectory(const string& dir)
+{
+    error_code error;
+    filesystem::create_directories(dir, error);
+    // lstat does not follow a link planted in place of the directory
+    struct stat info;
+    if(lstat(dir.c_str(), &info) != 0 or !S_ISDIR(info.st_mode) or info.st_uid != getuid())
+        return false;
+    return !(info.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+bool PriorCache::write(const string& path, const Header& header, const array<vector<double>, 2>& scores)
+{
+    // written to a new file with a unique name next to the target and renamed, concurrent writers of the same prior
+    // (processes or threads) replace each other atomically. The file is only readable by the user
+    string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(tmpPath.data());
+    if(fd < 0)
+        return false;
+    auto writeAll = [fd](const void* bytes, size_t size){
+        const char* ptr = static_cast<const char*>(bytes);
+        while(size > 0){
+            ssize_t written = ::write(fd, ptr, size);
+            if(written < 0){
+                if(errno == EINTR)
+                    continue;
+                return false;
+            }
+            ptr += written;
+            size -= written;
+        }
+        return true;
+    };
+    bool good = writeAll(&header, sizeof(Header));
+    for(const vector<double>& playerScores : scores)
+        good = good and writeAll(playerScores.data(), playerScores.size() * sizeof(double));
+    good = close(fd) == 0 and good;
+    if(!good or rename(tmpPath.c_str(), path.c_str()) != 0){
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PriorCache::map(const string& path, const Header& header)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW);
+    if(fd < 0)
+        return false;
+    struct stat info;
+    size_t size = sizeof(Header) + 2 * header.numMoves * sizeof(double);
+    if(fstat(fd, &info) != 0 or static_cast<size_t>(info.st_size) != size){
+        close(fd);
+        return false;
+    }
+    void* ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+    if(ptr == MAP_FAILED)
+        return false;
+    // a file of another version, board size, playout count or seed is stale
+    if(memcmp(ptr, &header, sizeof(Header)) != 0){
+        munmap(ptr, size);
+        return false;
+    }
+    mapping = ptr;
+    mappingSize = size;
+    static_assert(sizeof(Header) % sizeof(double) == 0, "the scores after the header must be aligned");
+    data = reinterpret_cast<const double*>(static_cast<const char*>(ptr) + sizeof(Header));
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef PRIORCACHE_H
+#define PRIORCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gamestate.h"
+
+using namespace std;
+
+class PriorCache
+/*
+ * initial MAST scores of a board size stored in a binary file per board size and seed. The scores are computed once by
+ * getInitialPolicy() from the prior stream of the global seed, later processes map the file read-only so the processes
+ * of a user share its pages. The file starts with a header holding the format version, the board size, the number of
+ * playouts and the seed, followed by the white then the black score of each move in native byte order. A missing or
+ * stale file is computed again and replaced by a rename, a process never maps a partially written file.
+ */
+{
+public:
+    // the files are created in the cache directory of the user unless another one is set. The directory is only used
+    // when it is owned by the user and not writable by others
+    static void setDirectory(const string& dir);
+    static string getDirectory();
+    // prior of the board of gameState, the state is expected to be at the start of the game
+    static shared_ptr<const PriorCache> load(GameState* gameState);
+
+    ~PriorCache();
+    PriorCache(const PriorCache&)=delete;
+    PriorCache& operator=(const PriorCache&)=delete;
+
+    inline unsigned int moveNum() const{
+        return numMoves;
+    }
+
+    // scores of the player for each move
+    inline const double* scores(Color player) const{
+        return data + player * numMoves;
+    }
+
+private:
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t boardSize;
+        uint32_t numMoves;
+        uint32_t numPlayouts;
+        uint64_t seed;
+    };
+    static constexpr uint32_t version = 2;
+
+    explicit PriorCache(unsigned int numMoves);
+    static string path(unsigned int boardSize, uint64_t seed);
+    // creates the directory if needed, false if other users could replace its files
+    static bool ownDirectory(const string& dir);
+    static bool write(const string& path, const Header& header, const array<vector<double>, 2>& scores);
+    // true if the file exists and matches the header
+    bool map(const string& path, const Header& header);
+
+    unsigned int numMoves;
+    const double* data;
+    void* mapping;
+    size_t mappingSize;
+    // the scores of this process when the file can not be written
+    vector<double> owned;
+    inline static string directory;
+};
+
+#endif // PRIORCACHE_H
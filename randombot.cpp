@@ -1,6 +1,6 @@
 #include "randombot.h"
 
-RandomBot::RandomBot(GameState* gameState, const QTime* timeLeft):
+RandomBot::RandomBot(GameState* gameState, const GameClock* timeLeft):
     AiBotBase(gameState, timeLeft)
 {}
 
@@ -4,7 +4,6 @@
 #include "aibotbase.h"
 
 #include <list>
-#include <QTime>
 #include <QThread>
 #include <QObject>
 
@@ -12,7 +11,7 @@ class RandomBot : public AiBotBase
 {
     Q_OBJECT
 public:
-    RandomBot(GameState* gameState, const QTime* timeLeft);
+    RandomBot(GameState* gameState, const GameClock* timeLeft);
     virtual ~RandomBot() override=default;
 
     void reset() override;
@@ -52,37 +52,30 @@ protected:
     explicit RecyclingNode(unsigned long int key):
         // wrapped node should have a key member for TT, p is for type deduction only
         T{key, RT::p}
-    {
-        ++RT::numNodes;
-    }
-
-    virtual ~RecyclingNode()
-    {
-        --RT::numNodes;
-    }
-
-    static void setup(unsigned int budget){
-        RT::budget = budget;
-        RT::numNodes = 0;
-    }
+    {}
 
-    static void reset(){
-        RT::fifo.clear();
-        RT::numNodes = 0;
-    }
+    virtual ~RecyclingNode()=default;
 
     void manageMemory(){
-        // node recycling
-        if(RT::numNodes >= RT::budget){
+        // node recycling, the fifo and the budget belong to the table so several tables can recycle independently
+        ZHashTable<RT>* tTable = NRT::context->tTable;
+        if(tTable->numNodes >= tTable->budget){
             // we could replace these to the destructor but that would confilct with the
             // hashtable's implementation
-            RT* front = RT::fifo.front();
+            RT* front = tTable->fifo.front();
+            // the root of the table is only released when the root moves, it could reach the front
+            if(front == tTable->root){
+                tTable->fifo.pop_front();
+                front->requeue();
+                front = tTable->fifo.front();
+            }
             // remove from fifo
-            RT::fifo.pop_front();
+            tTable->fifo.pop_front();
             // remove from TT
-            (front->listPtr)->erase(front->listIt);
+            tTable->erase(front->slot);
+            --tTable->numNodes;
             // deallocate node
-            delete front;
+            tTable->deallocate(front);
         }
     }
 
@@ -90,30 +83,33 @@ protected:
     {
         // we are a non-leaf node so remove from FIFO (and later push back during backpropagation)
         // erase through reverse iterator
-        RT::fifo.erase(fifoPtr);
+        NRT::context->tTable->fifo.erase(fifoPtr);
         return T::template select<RT>();
     }
 
     RT* selectMostVisited(){
-        return NRT::selectMostVisited();
+        return NRT::selectMostVisited(this);
     }
 
     RT* expand(){
         return T::template expand<RT>();
     }
 
+    // puts the node back at the end of the fifo after select() took it out
+    void requeue(){
+        NRT::context->tTable->fifo.push_back(this);
+        fifoPtr = NRT::context->tTable->fifo.end();
+        --fifoPtr;
+    }
+
     void backprop(double outcome)
     {
-        RT::fifo.push_back(this);
-        fifoPtr = RT::fifo.end();
-        --fifoPtr;
+        requeue();
         T::template backprop<RT>(outcome);
     }
 
     void backpropRoot(double outcome){
-        RT::fifo.push_back(this);
-        fifoPtr = RT::fifo.end();
-        --fifoPtr;
+        requeue();
         T::template backpropRoot<RT>(outcome);
     }
 
@@ -121,20 +117,18 @@ protected:
         T::template backward<RT>();
     }
 
-    void updateLeaf(unsigned int moveIdx, unsigned int childIdx){
-        T::updateLeaf(moveIdx, childIdx);
+    void collect(Color player, Color piece, unsigned int moveIdx){
+        T::template collect<RT>(player, piece, moveIdx);
     }
 
-    // number of available nodes
-    inline static unsigned int budget;
-    inline static unsigned int numNodes;
+    void updateLeaf(unsigned int moveIdx){
+        T::template updateLeaf<RT>(moveIdx);
+    }
 
-    inline static list<RT*> fifo;
     typename list<RT*>::iterator fifoPtr;
 
-    // iterator and pointer to list in TT
-    typename list<RT*>::iterator listIt;
-    list<RT*>* listPtr;
+    // entry of the node in TT
+    unsigned int slot;
 
     // pointer for type deduction in wrapped node constructor
     static constexpr RT* p=nullptr;
@@ -0,0 +1,65 @@
+#ifndef RELAXED_H
+#define RELAXED_H
+
+#include <atomic>
+
+using namespace std;
+
+template<typename T>
+class Relaxed
+/*
+ * statistic of a node that the other tree parallel workers read while it is updated. The updates of a node are
+ * serialized (one thread or the lock of the node), so a relaxed load and store are enough, the atomic only makes the
+ * concurrent reads well defined. On x86 they are plain moves.
+ */
+{
+public:
+    Relaxed():
+        value{}
+    {}
+
+    explicit Relaxed(T value):
+        value{value}
+    {}
+
+    Relaxed(const Relaxed& other):
+        value{other.load()}
+    {}
+
+    Relaxed& operator=(const Relaxed& other){
+        store(other.load());
+        return *this;
+    }
+
+    Relaxed& operator=(T other){
+        store(other);
+        return *this;
+    }
+
+    inline operator T() const{
+        return load();
+    }
+
+    inline Relaxed& operator++(){
+        store(load() + 1);
+        return *this;
+    }
+
+    inline Relaxed& operator--(){
+        store(load() - 1);
+        return *this;
+    }
+
+private:
+    inline T load() const{
+        return value.load(memory_order_relaxed);
+    }
+
+    inline void store(T other){
+        value.store(other, memory_order_relaxed);
+    }
+
+    atomic<T> value;
+};
+
+#endif // RELAXED_H
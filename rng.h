@@ -0,0 +1,118 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <limits>
+
+class Rng
+/*
+ * xoshiro256** generator, the source of every random draw of the engine. A generator is created for a stream of the
+ * global seed, streams are 2^128 draws apart so the generators of the components never overlap. A generator seeded by
+ * a draw of another one advances its source, the next copy gets another seed.
+ * Setting the global seed before creating the game state and the search reproduces a single threaded search with a
+ * playout or node budget exactly. The initial policy is computed from its own stream in the same way on any number of
+ * cores, so the draws are the same whether its cached file exists or not. It can be used with the distributions and
+ * algorithms of <random> and <algorithm>.
+ */
+{
+public:
+    typedef uint64_t result_type;
+
+    // streams of the global seed used by the components, a thread copy of the policy is seeded by a draw of its source
+    enum Stream{
+        ZobristStream,
+        StateStream,
+        PolicyStream,
+        RolloutStream,
+        OpponentStream,
+        BenchStream,
+        OpeningStream,
+        PerftStream,
+        PriorStream,
+    };
+
+    explicit Rng(unsigned int stream=0):
+        Rng(globalSeed, stream)
+    {}
+
+    Rng(uint64_t seed, unsigned int stream){
+        // splitmix64 spreads the seed over the state
+        uint64_t x = seed;
+        for(uint64_t& word : s){
+            uint64_t z = (x += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+        for(unsigned int i = 0; i < stream; ++i)
+            jump();
+    }
+
+    Rng(const Rng&)=default;
+    Rng& operator=(const Rng&)=default;
+
+    static void setSeed(uint64_t seed){
+        globalSeed = seed;
+    }
+
+    static uint64_t getSeed(){
+        return globalSeed;
+    }
+
+    static constexpr result_type min(){
+        return 0;
+    }
+
+    static constexpr result_type max(){
+        return std::numeric_limits<result_type>::max();
+    }
+
+    inline result_type operator()(){
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // uniform in [0, n), the bias of the multiplication is below n / 2^64
+    inline unsigned int below(unsigned int n){
+        return static_cast<unsigned int>((static_cast<unsigned __int128>((*this)()) * n) >> 64);
+    }
+
+    // uniform in [0, 1) with 53 random bits
+    inline double uniform(){
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // advances the state by 2^128 draws
+    void jump(){
+        static const uint64_t coefs[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for(uint64_t coef : coefs){
+            for(unsigned int bit = 0; bit < 64; ++bit){
+                if(coef & uint64_t(1) << bit){
+                    for(unsigned int i = 0; i < 4; ++i)
+                        t[i] ^= s[i];
+                }
+                (*this)();
+            }
+        }
+        for(unsigned int i = 0; i < 4; ++i)
+            s[i] = t[i];
+    }
+
+private:
+    static inline uint64_t rotl(uint64_t x, int k){
+        return (x << k) | (x >> (64 - k));
+    }
+
+    inline static uint64_t globalSeed = 0x4f6d656761;
+    uint64_t s[4];
+};
+
+#endif // RNG_H
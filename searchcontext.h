@@ -0,0 +1,50 @@
+#ifndef SEARCHCONTEXT_H
+#define SEARCHCONTEXT_H
+
+#include "selectkernel.h"
+
+// forward declarations
+class GameState;
+class MAST;
+
+template<typename T>
+class ZHashTable;
+
+template<typename T>
+class RecyclingNode;
+
+// type_traits for friend declarations
+template<typename T>
+struct WType{
+    typedef T type;
+};
+
+template<typename T>
+struct WType<RecyclingNode<T>>{
+    typedef T type;
+};
+
+template<typename T>
+struct SearchContext
+/*
+ * state of one search (one per table and per tree parallel worker). The nodes reach it through Node<T>::context,
+ * which the search binds on the thread it runs on, so several searches of the same node type can live in one process.
+ */
+{
+    GameState* gameState;
+    ZHashTable<T>* tTable;
+    MAST* policy;
+
+    // node to remove. Deallocation is postponed after backpropagation to avoid deleting a node from the path
+    T* rNode;
+
+    unsigned int currDepth;
+
+    // additional data of the node type collected during a playout
+    typename WType<T>::type::SearchData data;
+
+    // child values of the selected node
+    SelectBuffers<T> children;
+};
+
+#endif // SEARCHCONTEXT_H
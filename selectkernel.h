@@ -0,0 +1,131 @@
+#ifndef SELECTKERNEL_H
+#define SELECTKERNEL_H
+
+#include <cmath>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+template<typename T>
+struct SelectBuffers
+/*
+ * child values gathered by select() into contiguous arrays for the selection kernels, one set per search so the
+ * buffers are reused between the nodes.
+ */
+{
+    vector<T*> nodes;
+    vector<double> means;
+    vector<double> counts;
+    vector<double> amaf;
+
+    void reserve(unsigned int numChild){
+        // the buffers only grow, the first positions are overwritten by each select
+        if(nodes.size() < numChild){
+            nodes.resize(numChild);
+            means.resize(numChild);
+            counts.resize(numChild);
+            amaf.resize(numChild);
+        }
+    }
+};
+
+// The kernels return the index of the first maximum like a scalar loop with strict comparison would.
+
+// UCT-2: means[i] + sqrt(logc / counts[i])
+inline unsigned int argmaxUCT(const double* means, const unsigned int* counts, unsigned int n, double logc)
+{
+    unsigned int i = 0;
+    double maxScore = -1;
+    unsigned int bestIdx = 0;
+#ifdef __AVX2__
+    if(n >= 4){
+        const __m256d vLogc = _mm256_set1_pd(logc);
+        const __m256d vStep = _mm256_set1_pd(4);
+        __m256d vIdx = _mm256_setr_pd(0, 1, 2, 3);
+        __m256d vMax = _mm256_set1_pd(-1);
+        __m256d vBest = _mm256_setzero_pd();
+        for(; i + 4 <= n; i += 4){
+            __m256d vCount = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + i)));
+            __m256d vScore = _mm256_add_pd(_mm256_loadu_pd(means + i), _mm256_sqrt_pd(_mm256_div_pd(vLogc, vCount)));
+            // each lane keeps its first maximum
+            __m256d greater = _mm256_cmp_pd(vScore, vMax, _CMP_GT_OQ);
+            vMax = _mm256_blendv_pd(vMax, vScore, greater);
+            vBest = _mm256_blendv_pd(vBest, vIdx, greater);
+            vIdx = _mm256_add_pd(vIdx, vStep);
+        }
+        alignas(32) double lanesMax[4];
+        alignas(32) double lanesBest[4];
+        _mm256_store_pd(lanesMax, vMax);
+        _mm256_store_pd(lanesBest, vBest);
+        // equal maxima of different lanes are resolved by the lower index
+        for(unsigned int lane = 0; lane < 4; ++lane){
+            if(lanesMax[lane] > maxScore or (lanesMax[lane] == maxScore and lanesBest[lane] < bestIdx)){
+                maxScore = lanesMax[lane];
+                bestIdx = lanesBest[lane];
+            }
+        }
+    }
+#endif
+    for(; i < n; ++i){
+        double score = means[i] + sqrt(logc / counts[i]);
+        if(score > maxScore){
+            maxScore = score;
+            bestIdx = i;
+        }
+    }
+    return bestIdx;
+}
+
+// RAVE: (1-beta) * means[i] + beta * amaf[i] with beta = sqrt(k / (counts[i] + k))
+inline unsigned int argmaxRAVE(const double* means, const double* counts, const double* amaf, unsigned int n, double k)
+{
+    unsigned int i = 0;
+    double maxScore = -1;
+    unsigned int bestIdx = 0;
+#ifdef __AVX2__
+    if(n >= 4){
+        const __m256d vK = _mm256_set1_pd(k);
+        const __m256d vOne = _mm256_set1_pd(1);
+        const __m256d vStep = _mm256_set1_pd(4);
+        __m256d vIdx = _mm256_setr_pd(0, 1, 2, 3);
+        __m256d vMax = _mm256_set1_pd(-1);
+        __m256d vBest = _mm256_setzero_pd();
+        for(; i + 4 <= n; i += 4){
+            __m256d vBeta = _mm256_sqrt_pd(_mm256_div_pd(vK, _mm256_add_pd(_mm256_loadu_pd(counts + i), vK)));
+            __m256d vScore = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(vOne, vBeta), _mm256_loadu_pd(means + i)),
+                                           _mm256_mul_pd(vBeta, _mm256_loadu_pd(amaf + i)));
+            // each lane keeps its first maximum
+            __m256d greater = _mm256_cmp_pd(vScore, vMax, _CMP_GT_OQ);
+            vMax = _mm256_blendv_pd(vMax, vScore, greater);
+            vBest = _mm256_blendv_pd(vBest, vIdx, greater);
+            vIdx = _mm256_add_pd(vIdx, vStep);
+        }
+        alignas(32) double lanesMax[4];
+        alignas(32) double lanesBest[4];
+        _mm256_store_pd(lanesMax, vMax);
+        _mm256_store_pd(lanesBest, vBest);
+        // equal maxima of different lanes are resolved by the lower index
+        for(unsigned int lane = 0; lane < 4; ++lane){
+            if(lanesMax[lane] > maxScore or (lanesMax[lane] == maxScore and lanesBest[lane] < bestIdx)){
+                maxScore = lanesMax[lane];
+                bestIdx = lanesBest[lane];
+            }
+        }
+    }
+#endif
+    for(; i < n; ++i){
+        double beta = sqrt(k / (counts[i] + k));
+        double score = (1-beta) * means[i] + beta * amaf[i];
+        if(score > maxScore){
+            maxScore = score;
+            bestIdx = i;
+        }
+    }
+    return bestIdx;
+}
+
+#endif // SELECTKERNEL_H
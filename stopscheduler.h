@@ -1,23 +1,24 @@
 #ifndef STOPSCHEDULER_H
 #define STOPSCHEDULER_H
 
+#include "timedscheduler.h"
 #include "zhashtable.h"
-#include "stopscheduler.h"
 #include <cassert>
 #include <math.h>
 
 #define assertm(exp, msg) assert(((void)msg, exp))
 
 template<typename T>
-class StopScheduler{
+class StopScheduler: public TimedScheduler
+{
 public:
-    StopScheduler(const QTime* timeLeft,
+    StopScheduler(const GameClock* timeLeft,
                   GameState* gameState,
                   ZHashTable<T>* tTable,
                   double p=0.9,
-                  unsigned int freq=100,
+                  double checkMsecs=0.5,
                   double reserveTime=1);
-    virtual ~StopScheduler()=default;
+    virtual ~StopScheduler() override=default;
 
     bool finish();
     void schedule();
@@ -26,18 +27,6 @@ public:
 protected:
     // p * msecsBudget time is given to the second best child to catch up
     const double p;
-    // frequency of checking stop condition. Make sure that reserveTime is large enough to avoid running out of time
-    const unsigned int freq;
-    double reserveTime;
-    // round per milliseconds
-    double speed;
-    // elapsed time in milliseconds from the start of the current round
-    unsigned int elapsedmsecs;
-    // base time devoted for the current round
-    unsigned int msecsBudget;
-    // number of playouts since the beginnign of the current round
-    double numPlayouts;
-    QTime startTime;
     double n;
 
     // parabolic parameters
@@ -45,28 +34,23 @@ protected:
     double b;
     double c;
     double w;
-    const QTime* timeLeft;
     GameState* gameState;
     ZHashTable<T>* tTable;
 };
 
 template<typename T>
-StopScheduler<T>::StopScheduler(const QTime* timeLeft,
+StopScheduler<T>::StopScheduler(const GameClock* timeLeft,
                                        GameState* gameState,
                                        ZHashTable<T>* tTable,
                                        double p,
-                                       unsigned int freq,
+                                       double checkMsecs,
                                        double reserveTime):
-    timeLeft{timeLeft},
+    TimedScheduler(timeLeft, reserveTime, checkMsecs),
     gameState{gameState},
     tTable{tTable},
-    p{p},
-    freq{freq},
-    reserveTime{reserveTime}
+    p{p}
 {
     assertm((p >= 0 or p<=1), "p argument should be greater than 0 and smaller or equal to 1");
-    assertm(reserveTime > 0, "reserveTime argument should be at least 0");
-    assertm(freq >= 2, "freq argument should be at least 2");
     // compute parabolic time distrubution: m is for the middle and s is for the starting move
     // we are fitting a parabolic curve to 3 points: (x1,y1), (x2,y2), (x3,y3)
     n = gameState->numExpectedMoves();
@@ -94,16 +78,11 @@ StopScheduler<T>::StopScheduler(const QTime* timeLeft,
 
 template<typename T>
 bool StopScheduler<T>::finish(){
-    ++numPlayouts;
-    // Make sure that reserve time is large enough to run full cycles at least frequency times otherwise
-    // it is not quaranteed that the AI not runs out of time
-    if(fmod(numPlayouts+1, freq) != 0.0)
+    if(!checkDue())
         return false;
-    elapsedmsecs = (*timeLeft).msecsTo(startTime);
     // if the time spent for current search is more than the budget
-    if(msecsBudget <= elapsedmsecs)
-        return true;
-    speed = numPlayouts / elapsedmsecs;
+    if(aborted() or msecsBudget <= elapsedmsecs)
+        return endRound();
     double maxScore;
     double secondMaxScore;
     double score;
@@ -113,9 +92,12 @@ bool StopScheduler<T>::finish(){
     T* secondBestNode;
     maxScore = -1;
     secondMaxScore = -1;
-    for(unsigned int moveIdx : gameState->validMoves){
-        Node<T>::tTable->update(moveIdx);
-        node = Node<T>::tTable->load();
+    bestNode = nullptr;
+    // the search root is the root of the table
+    T* root = Node<T>::context->tTable->root;
+    ChildEdge* edges = root->template edges<T>();
+    for(unsigned int idx = 0; idx < root->childNum(); ++idx){
+        node = Node<T>::child(edges[idx]);
         score = node ? node->visitCount() : 0;
         if(score > maxScore){
             secondMaxScore = maxScore;
@@ -127,34 +109,33 @@ bool StopScheduler<T>::finish(){
             secondMaxScore = score;
             secondBestNode = node;
         }
-        Node<T>::tTable->update(moveIdx);
     }
+    // no child has been visited yet
+    if(!bestNode)
+        return false;
     // most likely there is no way for the AI to win
     if(bestNode->stateScore() < 0.01 and elapsedmsecs >= 500){
-        return true;
+        return endRound();
     }
     // most likely the AI won
     if(bestNode->stateScore() > 0.99 and elapsedmsecs >= 500){
-        return true;
+        return endRound();
     }
     // check if the best node can change within the dedicated time frame
     // estimate  of minimum number of playouts to change the best node (with regard to the visit count)
     double minPlayouts = maxScore - secondMaxScore;
     // check if the expected number of playouts that can be carried out within the dedicated time frame is smaller
     if(minPlayouts > p / w * speed * (msecsBudget - elapsedmsecs)){
-        return true;
+        return endRound();
     }
     return false;
 }
 
 template<typename T>
 void StopScheduler<T>::schedule(){
-    numPlayouts = -1;
-    startTime = *timeLeft;
-    int rmsecs = QTime(0, 0, 0, 0).msecsTo(startTime) - reserveTime * 1000;
     n = gameState->numExpectedMoves();
     w  = (a*n*n + b*n + c);
-    msecsBudget = w / n * (rmsecs > 0 ? rmsecs : 1);
+    startRound(w / n);
 }
 
 #endif // STOPSCHEDULER_H
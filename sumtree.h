@@ -0,0 +1,59 @@
+#ifndef SUMTREE_H
+#define SUMTREE_H
+
+#include <vector>
+
+using namespace std;
+
+class SumTree
+/*
+ * non-negative weights of a fixed number of items in a complete binary tree where each inner node is the sum of its
+ * children. Changing a weight and drawing an item proportionally to its weight are O(log n). The parents are summed
+ * again on each change instead of adding the difference, so rounding errors do not accumulate.
+ */
+{
+public:
+    explicit SumTree(unsigned int size=0):
+        numLeaves{1}
+    {
+        while(numLeaves < size)
+            numLeaves *= 2;
+        sums.assign(2 * numLeaves, 0);
+    }
+
+    inline void set(unsigned int idx, double weight){
+        unsigned int node = numLeaves + idx;
+        sums[node] = weight;
+        for(node /= 2; node > 0; node /= 2)
+            sums[node] = sums[2 * node] + sums[2 * node + 1];
+    }
+
+    inline double get(unsigned int idx) const{
+        return sums[numLeaves + idx];
+    }
+
+    inline double total() const{
+        return sums[1];
+    }
+
+    // item at the position r in [0, total()) of the cumulated weights
+    inline unsigned int find(double r) const{
+        unsigned int node = 1;
+        while(node < numLeaves){
+            node *= 2;
+            // a right subtree without weight is never taken, even if rounding pushed r beyond the left sum
+            if(r >= sums[node] and sums[node + 1] > 0){
+                r -= sums[node];
+                ++node;
+            }
+        }
+        return node - numLeaves;
+    }
+
+private:
+    unsigned int numLeaves;
+    // sums[1] is the root, the children of i are 2i and 2i+1, the leaves start at numLeaves
+    vector<double> sums;
+};
+
+#endif // SUMTREE_H
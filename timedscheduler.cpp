@@ -0,0 +1,55 @@
+#include "timedscheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#define assertm(exp, msg) assert(((void)msg, exp))
+
+TimedScheduler::TimedScheduler(const GameClock* timeLeft, double reserveTime, double checkMsecs):
+    timeLeft{timeLeft},
+    reserveTime{reserveTime},
+    checkMsecs{checkMsecs},
+    numPlayouts{0},
+    nextCheck{1},
+    speed{0},
+    elapsedmsecs{0},
+    msecsBudget{0}
+{
+    assertm(reserveTime > 0, "reserveTime argument should be at least 0");
+    assertm(checkMsecs > 0, "checkMsecs argument should be greater than 0");
+}
+
+void TimedScheduler::startRound(double share){
+    startTime = chrono::steady_clock::now();
+    numPlayouts = 0;
+    nextCheck = 1;
+    elapsedmsecs = 0;
+    double reserveMsecs = reserveTime * 1000;
+    double mainMsecs = timeLeft->mainRemaining();
+    double periodMsecs = timeLeft->periodRemaining();
+    // the increment is not added anymore once the player is in byo-yomi
+    msecsBudget = share * max(mainMsecs - reserveMsecs, 0.0) + (mainMsecs > 0 ? timeLeft->increment() : 0);
+    // the period is used anyway once the main time is over, the reserve keeps it from being lost
+    if(periodMsecs > 0)
+        msecsBudget += max(periodMsecs - reserveMsecs, periodMsecs / 2);
+    // a move never runs into the loss of a period or of the game
+    msecsBudget = min(msecsBudget, mainMsecs + periodMsecs - marginMsecs);
+    msecsBudget = max(msecsBudget, 1.0);
+    watchdog.arm(startTime + chrono::microseconds(static_cast<long int>(msecsBudget * 1000)));
+}
+
+bool TimedScheduler::checkDue(){
+    ++numPlayouts;
+    if(aborted())
+        return true;
+    if(numPlayouts < nextCheck)
+        return false;
+    elapsedmsecs = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    speed = numPlayouts / max(elapsedmsecs, 1e-3);
+    nextCheck = numPlayouts + max(1.0, floor(speed * checkMsecs));
+    return true;
+}
+
+bool TimedScheduler::endRound(){
+    watchdog.disarm();
+    return true;
+}
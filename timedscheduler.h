@@ -0,0 +1,56 @@
+#ifndef TIMEDSCHEDULER_H
+#define TIMEDSCHEDULER_H
+
+#include <chrono>
+
+#include "gameclock.h"
+#include "watchdog.h"
+
+using namespace std;
+
+class TimedScheduler
+/*
+ * time keeping shared by the schedulers. The budget of a move is measured on the monotonic clock from the start of
+ * the round. The stop conditions are checked after about checkMsecs whatever the board size, the interval in
+ * playouts follows the measured playout speed. A watchdog raises aborted() at the end of the budget so that a long
+ * playout is cut short instead of overshooting the deadline.
+ */
+{
+public:
+    // the budget of the round is over, a playout in progress should stop
+    inline bool aborted() const{
+        return watchdog.expired();
+    }
+
+protected:
+    TimedScheduler(const GameClock* timeLeft, double reserveTime, double checkMsecs);
+    virtual ~TimedScheduler()=default;
+
+    // share of the main time given to this move, the increment (in main time) and a byo-yomi period come on top of it
+    void startRound(double share);
+    // counts a playout, true if the stop conditions should be checked now
+    bool checkDue();
+    // the round is over, always true so that finish() can return it
+    bool endRound();
+
+    // margin to the loss of a period or of the game, the overshoot of the budget stays below it
+    static constexpr double marginMsecs = 5;
+
+    const GameClock* timeLeft;
+    double reserveTime;
+    const double checkMsecs;
+    // number of playouts since the beginning of the current round
+    double numPlayouts;
+    // the stop conditions are checked when numPlayouts reaches it
+    double nextCheck;
+    // playouts per milliseconds
+    double speed;
+    // elapsed time in milliseconds from the start of the current round
+    double elapsedmsecs;
+    // time devoted for the current round
+    double msecsBudget;
+    chrono::steady_clock::time_point startTime;
+    Watchdog watchdog;
+};
+
+#endif // TIMEDSCHEDULER_H
@@ -2,10 +2,11 @@
 #define UCTNODE_H
 
 #include "recyclingnode.h"
+#include "relaxed.h"
 #include <math.h>
 
+#include <algorithm>
 #include <map>
-#include <vector>
 
 class UCTNode
 {
@@ -24,17 +25,25 @@ public:
     template<typename T=UCTNode>
     inline T* expand();
 
-    inline void updateLeaf(unsigned int moveIdx, unsigned int childIdx);
+    template<typename T=UCTNode>
+    inline void updateLeaf(unsigned int moveIdx);
+
+    inline void addVirtualLoss();
+    inline void removeVirtualLoss();
 
     template<typename T=UCTNode>
     inline void backprop(double outcome);
 
     template<typename T=UCTNode>
-    inline void backpropRoot(double outcome) {}
+    inline void backpropRoot(double) {}
 
     template<typename T=UCTNode>
     inline void backward();
 
+    // a move of the playout taken back on another state than the one of the search, nothing is collected
+    template<typename T=UCTNode>
+    inline void collect(Color, Color, unsigned int) {}
+
     template<typename T=UCTNode>
     inline void manageMemory();
 
@@ -43,112 +52,162 @@ public:
 
     inline double stateScore() const;
     inline double visitCount() const;
+    inline double virtualScore() const;
 
+    // bytes of child edges and statistics stored after the node
+    static constexpr size_t extraSize(unsigned int numChild){
+        return numChild * (sizeof(ChildEdge) + sizeof(unsigned int));
+    }
+    inline size_t extraSize() const;
+
+    // children in the order of the valid moves when the node was created, the table allocates them right after the
+    // node of type T
     template<typename T=UCTNode>
-    inline double actionScore(UCTNode* child, unsigned int moveIdx, unsigned int childIdx, Color playerColor) const;
+    inline ChildEdge* edges();
+    inline unsigned int childNum() const;
 
     // c value for balancing exploration and exploitation
     static constexpr double c = 2.0;
-    static constexpr double initialvCount = 1.0;
+    static constexpr unsigned int initialvCount = 1;
+
+    // no additional data is collected during a playout
+    struct SearchData{};
 
 protected:
     template<typename T=UCTNode>
     UCTNode(unsigned long int key, const T* =nullptr);
 
-    template<typename T=UCTNode>
-    inline static void setup(MAST* policy, GameState* gameState, ZHashTable<T>* tTable);
-
-    inline static void reset() {}
-
     virtual ~UCTNode()=default;
 
+    // the child statistics are copied by the table
     UCTNode(const UCTNode&)=default;
-    UCTNode& operator=(const UCTNode&)=default;
-
-    double mean;
-    double vCount;
-    vector<double> vCounts;
-    inline static double logc;
+    UCTNode& operator=(const UCTNode&)=delete;
+
+    // child visit counts, after the child edges
+    template<typename T>
+    inline unsigned int* vCounts();
+    template<typename T>
+    inline const unsigned int* vCounts() const;
+
+    // read by the selection of the parents
+    Relaxed<double> mean;
+    Relaxed<double> vCount;
+    // number of unfinished descents through the node, counted as lost playouts until backpropagation
+    Relaxed<unsigned int> vLoss;
+    unsigned int numChild;
 };
 
 template<typename T>
 UCTNode::UCTNode(unsigned long int key, const T*):
     key{key},
-    depth{Node<T>::currDepth},
-    vCounts{}
+    depth{Node<T>::context->currDepth},
+    vLoss{0}
 {
-    mean = depth > 0 ? Node<T>::policy->getScore(Node<T>::gameState->takenMove(), Node<T>::gameState->getPreviousPlayer()) : 0.5;
-    unsigned int numChild = Node<T>::gameState->validMoves.size();
+    SearchContext<T>* ctx = Node<T>::context;
+    mean = depth > 0 ? ctx->policy->getScore(ctx->gameState->takenMove(), ctx->gameState->getPreviousPlayer()) : 0.5;
+    numChild = ctx->gameState->validMoves.size();
+    // children are resolved when they are first selected
+    ChildEdge* edge = edges<T>();
+    for(unsigned int moveIdx : ctx->gameState->validMoves)
+        *edge++ = {moveIdx, 0, 0};
     auto iCount = UCTNode::initialvCount;
     vCount = iCount * numChild;
-    vCounts = vector<double> (numChild, iCount);
+    fill_n(vCounts<T>(), numChild, iCount);
 }
 
 template<typename T>
-void UCTNode::setup(MAST* policy, GameState* gameState, ZHashTable<T>* tTable)
-{
-    Node<T>::setup(policy, gameState, tTable);
+ChildEdge* UCTNode::edges(){
+    return reinterpret_cast<ChildEdge*>(reinterpret_cast<char*>(this) + sizeof(T));
+}
+
+unsigned int UCTNode::childNum() const {
+    return numChild;
+}
+
+template<typename T>
+unsigned int* UCTNode::vCounts(){
+    return reinterpret_cast<unsigned int*>(edges<T>() + numChild);
+}
+
+template<typename T>
+const unsigned int* UCTNode::vCounts() const{
+    return reinterpret_cast<const unsigned int*>(reinterpret_cast<const char*>(this) + sizeof(T) + numChild * sizeof(ChildEdge));
+}
+
+size_t UCTNode::extraSize() const {
+    return UCTNode::extraSize(numChild);
 }
 
 template<typename T>
 T* UCTNode::select(){
-    double maxScore = -1;
-    double score;
-    unsigned int bestMoveIdx;
-    T* bestChild;
-    unsigned int idx=0;
-    unsigned int bestIdx;
-    UCTNode::logc = UCTNode::c * log(vCount + 1);
-    Color playerColor = Node<T>::gameState->getCurrentPlayer();
-    for(unsigned int moveIdx : Node<T>::gameState->validMoves){
-        Node<T>::tTable->update(moveIdx);
-        T* child = Node<T>::tTable->load();
-        score = actionScore<T>(child, moveIdx, idx, playerColor);
-        if(score > maxScore){
-            maxScore = score;
-            bestChild = child;
-            bestMoveIdx = moveIdx;
-            bestIdx = idx;
-        }
-        // xor twice with the same value gives back the original
-        Node<T>::tTable->update(moveIdx);
-        ++idx;
+    SearchContext<T>* ctx = Node<T>::context;
+    SelectBuffers<T>& children = ctx->children;
+    children.reserve(numChild);
+    ChildEdge* edge = edges<T>();
+    Color playerColor = ctx->gameState->getCurrentPlayer();
+    // gather the child values, unexplored children get the score of the default policy
+    for(unsigned int idx = 0; idx < numChild; ++idx){
+        T* child = Node<T>::child(edge[idx]);
+        children.nodes[idx] = child;
+        children.means[idx] = child ? child->virtualScore() : ctx->policy->getScore(edge[idx].moveIdx, playerColor);
     }
+    unsigned int bestIdx = argmaxUCT(children.means.data(), vCounts<T>(), numChild, UCTNode::c * log(vCount + 1));
     // update visit counts
     ++vCount;
-    ++vCounts[bestIdx];
+    ++vCounts<T>()[bestIdx];
     // visit the node
-    Node<T>::gameState->update(bestMoveIdx);
-    Node<T>::tTable->update(bestMoveIdx);
-    return bestChild;
+    unsigned int bestMoveIdx = edge[bestIdx].moveIdx;
+    ctx->gameState->update(bestMoveIdx);
+    ctx->tTable->update(bestMoveIdx);
+    return children.nodes[bestIdx];
 }
 
 template<typename T>
 void UCTNode::backprop(double outcome){
-    unsigned int moveIdx = Node<T>::gameState->takenMove();
+    SearchContext<T>* ctx = Node<T>::context;
+    unsigned int moveIdx = ctx->gameState->takenMove();
     // currentPlayer is the next player to move. We use the player who played the move
-    Node<T>::gameState->undo();
-    double val = outcome+Node<T>::gameState->getCurrentPlayer()*(1.0-2.0*outcome);
+    ctx->gameState->undo();
+    double val = outcome+ctx->gameState->getCurrentPlayer()*(1.0-2.0*outcome);
     mean = (mean*(vCount-1)+val)/(vCount);
-    Node<T>::tTable->update(moveIdx);
+    ctx->tTable->update(moveIdx);
 }
 
-void UCTNode::updateLeaf(unsigned int moveIdx, unsigned int childIdx) {
+template<typename T>
+void UCTNode::updateLeaf(unsigned int moveIdx) {
+    // the simulated move counts as a visit of its child
+    ChildEdge* edge = edges<T>();
+    unsigned int childIdx = 0;
+    while(edge[childIdx].moveIdx != moveIdx){
+        ++childIdx;
+        assertm(childIdx < numChild, "the simulated move should be a child of the leaf");
+    }
     ++vCount;
-    ++vCounts[childIdx];
+    ++vCounts<T>()[childIdx];
+}
+
+void UCTNode::addVirtualLoss() {
+    ++vLoss;
+}
+
+void UCTNode::removeVirtualLoss() {
+    --vLoss;
 }
 
 double UCTNode::stateScore() const {
     return mean;
 }
 
-double UCTNode::visitCount() const {
-    return vCount;
+double UCTNode::virtualScore() const {
+    // pending visits are already in vCount but not in mean, so they are weighted as losses. Each statistic is read once,
+    // another worker could be updating them
+    double count = vCount;
+    unsigned int pending = vLoss;
+    return pending ? mean * (count - pending) / count : mean;
 }
 
-template<typename T>
-double UCTNode::actionScore(UCTNode* child, unsigned int moveIdx, unsigned int childIdx, Color playerColor) const {
-    return (child ? child->mean : Node<T>::policy->getScore(moveIdx, playerColor)) + sqrt(UCTNode::logc / vCounts[childIdx]);
+double UCTNode::visitCount() const {
+    return vCount;
 }
 
 template<typename T>
@@ -156,17 +215,17 @@ void UCTNode::backward(){
     return Node<T>::backward();
 }
 
-template<typename T=UCTNode>
+template<typename T>
 T* UCTNode::selectMostVisited(){
-    return Node<T>::selectMostVisited();
+    return Node<T>::selectMostVisited(static_cast<T*>(this));
 }
 
-template<typename T=UCTNode>
+template<typename T>
 T* UCTNode::expand(){
     return Node<T>::expand();
 }
 
-template<typename T=UCTNode>
+template<typename T>
 void UCTNode::manageMemory(){
     Node<T>::manageMemory();
 }
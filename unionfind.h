@@ -0,0 +1,71 @@
+#ifndef UNIONFIND_H
+#define UNIONFIND_H
+
+#include <vector>
+
+using namespace std;
+
+class UnionFind
+/*
+ * disjoint sets of cells with union by size and an undo log. There is no path compression so that the last unions can
+ * be rolled back, union by size keeps the parent chains shorter than log2(size). The arrays are sized at construction
+ * and the log holds at most one entry per element, so unite() and undo() do not allocate.
+ */
+{
+public:
+    explicit UnionFind(unsigned int size):
+        parents(size),
+        sizes(size),
+        log(size),
+        logSize{0}
+    {
+        for(unsigned int i = 0; i < size; ++i){
+            parents[i] = i;
+            sizes[i] = 1;
+        }
+    }
+
+    // representative of the set of idx
+    inline unsigned int find(unsigned int idx) const{
+        while(parents[idx] != idx)
+            idx = parents[idx];
+        return idx;
+    }
+
+    // number of elements in the set of the representative root
+    inline unsigned int size(unsigned int root) const{
+        return sizes[root];
+    }
+
+    // joins the sets of two different representatives and returns the new representative
+    inline unsigned int unite(unsigned int root, unsigned int other){
+        if(sizes[root] < sizes[other])
+            std::swap(root, other);
+        parents[other] = root;
+        sizes[root] += sizes[other];
+        log[logSize++] = other;
+        return root;
+    }
+
+    // number of unions that can be undone
+    inline unsigned int numUnions() const{
+        return logSize;
+    }
+
+    // splits the last union
+    inline void undo(){
+        unsigned int other = log[--logSize];
+        unsigned int root = parents[other];
+        sizes[root] -= sizes[other];
+        parents[other] = other;
+    }
+
+private:
+    vector<unsigned int> parents;
+    vector<unsigned int> sizes;
+    // the joined representatives in the order of the unions
+    vector<unsigned int> log;
+    unsigned int logSize;
+};
+
+#endif // UNIONFIND_H
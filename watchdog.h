@@ -0,0 +1,95 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Watchdog
+/*
+ * raises a flag when a deadline passes. It waits on its own thread, so a search that polls expired() notices the
+ * deadline in the middle of a playout instead of at the next clock check. The thread is started by the first arm and
+ * lives as long as the watchdog, arming and disarming only wake it up.
+ */
+{
+public:
+    Watchdog():
+        armed{false},
+        quit{false},
+        round{0},
+        flag{false}
+    {}
+
+    ~Watchdog(){
+        if(!waiter.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wakeUp.notify_one();
+        waiter.join();
+    }
+
+    Watchdog(const Watchdog&)=delete;
+    Watchdog& operator=(const Watchdog&)=delete;
+
+    void arm(std::chrono::steady_clock::time_point deadline){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            flag.store(false, std::memory_order_relaxed);
+            this->deadline = deadline;
+            armed = true;
+            ++round;
+        }
+        if(!waiter.joinable())
+            waiter = std::thread(&Watchdog::wait, this);
+        else
+            wakeUp.notify_one();
+    }
+
+    void disarm(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!armed)
+                return;
+            armed = false;
+        }
+        wakeUp.notify_one();
+    }
+
+    inline bool expired() const{
+        return flag.load(std::memory_order_relaxed);
+    }
+
+private:
+    void wait(){
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!quit){
+            if(!armed){
+                wakeUp.wait(lock, [this]{ return armed or quit; });
+                continue;
+            }
+            // a new arm or a disarm ends the wait of the current round
+            unsigned long int current = round;
+            if(!wakeUp.wait_until(lock, deadline, [this, current]{ return !armed or quit or round != current; })){
+                flag.store(true, std::memory_order_relaxed);
+                armed = false;
+            }
+        }
+    }
+
+    std::thread waiter;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::chrono::steady_clock::time_point deadline;
+    bool armed;
+    bool quit;
+    // number of arms, tells the waiting thread that the deadline changed
+    unsigned long int round;
+    std::atomic<bool> flag;
+};
+
+#endif // WATCHDOG_H
@@ -3,15 +3,26 @@
 
 #include <vector>
 #include <list>
+#include <memory>
 #include <utility>
 
 template<typename T>
 class ZHashTable;
+template<typename T>
+class NodeBudgetScheduler;
 
 #include "recyclingnode.h"
+#include "nodepool.h"
+#include "rng.h"
 
-#include <random>
+#include <atomic>
+#include <cassert>
+#include <cstring>
 #include <limits>
+#include <new>
+#include <sys/mman.h>
+
+#define assertm(exp, msg) assert(((void)msg, exp))
 
 // type_traits to get wrapped node type
 template<typename T>
@@ -30,107 +41,279 @@ class ZHashTableBase{};
 
 template<typename T>
 class ZHashTable: ZHashTableBase
+/*
+ * open addressing transposition table: each bucket is a cache line holding the verification keys next to the 32 bit
+ * handles of the nodes in the pool, so a probe reads one line and no node. There are two entries per hash code, as in
+ * the lists of two nodes the table replaced. Stores and removals are serialized by the caller, the version of a bucket
+ * lets the probes go without a lock while another thread stores.
+ */
 {
     // there is no partial specialization for friend declaration
     template<typename X, typename Y, typename Z>
     friend class MCTS;
+    template<typename X, typename Y, typename Z>
+    friend class TreeParallelMCTS;
+    template<typename X, typename Y, typename Z>
+    friend class RootParallelMCTS;
+    friend class StopScheduler<T>;
+    friend class NodeBudgetScheduler<T>;
+    // recycling nodes manage the fifo of their table
+    friend T;
+    // removed nodes are given back to the pool
+    friend class Node<T>;
 public:
     ZHashTable(GameState* gameState, MAST* policy, unsigned int LenHashCode=20, unsigned int budget=50000);
+    // view sharing the nodes of the table with its own zobrist cursor and context (one per search thread)
+    ZHashTable(ZHashTable* shared, GameState* gameState, MAST* policy);
 
     void reset();
 
-    ~ZHashTable()=default;
+    ~ZHashTable();
 
     ZHashTable(const ZHashTable&)=delete;
     ZHashTable& operator=(const ZHashTable&)=delete;
 
     void update(unsigned int moveIdx);
     T* updateRoot(unsigned int moveIdx);
+    // the root moves to the current position, e.g. after the search played its moves. The nodes above it become the
+    // first to be replaced, so the search can go on from there
+    T* advanceRoot();
     T* load();
+    // load that also gives the handle of the node
+    T* load(unsigned int& handle);
     T* store();
 
+    // make the context of the table the one used by the nodes on the calling thread
+    void bind();
+
+    // verification key of the current position
+    inline unsigned long int positionKey() const{
+        return currKey;
+    }
+
     typedef typename isRecycled<T>::wtype wType;
     static constexpr bool isRecycledType = isRecycled<T>::value;
 
+    // number of entries in a bucket
+    static constexpr unsigned int bucketSize = 5;
+
 protected:
+    struct alignas(64) Bucket{
+        // a key is only valid together with a non-zero handle
+        atomic<unsigned long int> keys[bucketSize]{};
+        // references of the nodes in the pool, 0 is an empty entry
+        atomic<unsigned int> handles[bucketSize]{};
+        // odd while a store or an erase writes the entries, a probe reads them again when it changed
+        atomic<unsigned short> version{};
+        // set when a store had to continue in the next bucket (recycling only), cleared on reset
+        atomic<bool> overflow{};
+    };
+    static_assert(sizeof(Bucket) == 64, "a bucket should fill one cache line");
+
+    struct Storage{
+        Storage(unsigned long int numBuckets);
+        ~Storage();
+        // mapped on huge pages where the system allows it, so the probes rarely miss the TLB
+        Bucket* buckets;
+        unsigned long int numBuckets;
+        // memory of the nodes, including the root. A handle is the reference of a node in the pool, its generation is
+        // incremented when the node is removed and read without lock by the tree parallel workers
+        NodePool<T> pool;
+        // number of nodes stored since the construction of the table, read by the node budget scheduler
+        atomic<unsigned long int> numStores;
+    };
+
+    // new node for the current game state and a copy of a node, both with their extra data
+    T* allocate(unsigned long int key);
+    T* allocate(const T* node);
+    void deallocate(T* node);
+
+    // node of a resolved child edge if it was not removed since
+    T* resolve(const ChildEdge& edge) const;
+    unsigned int generation(unsigned int handle) const;
+
+    // bucket of a hash code, the code is scaled to the number of buckets
+    inline unsigned long int bucketOf(unsigned long int code) const{
+        return code * numBuckets >> 32;
+    }
+    inline unsigned long int nextBucket(unsigned long int bucket) const{
+        return bucket + 1 == numBuckets ? 0 : bucket + 1;
+    }
+
+    void insert(unsigned int slot, T* node);
+    void erase(unsigned int slot);
+    void clear();
+
     unsigned int LenHashCode;
-    unsigned long int hashCodeMask;
-    vector<list<T*>> table;
+    // buckets for 2^(LenHashCode+1) entries
+    unsigned long int numBuckets;
+    // buckets are shared between the views of the table
+    shared_ptr<Storage> table;
+    // storage arrays of the table, they are never resized so the probes skip the shared pointer
+    Bucket* buckets;
+    NodePool<T>* pool;
     vector<unsigned long int> hashCodes;
     vector<unsigned long int> hashKeys;
     unsigned long int currCode;
     unsigned long int currKey;
     // root node
     T* root;
+    // state of the search using the table
+    SearchContext<T> context;
+
+    // node recycling: number of available nodes, number of stored nodes and the nodes in least recently used order
+    unsigned int budget;
+    unsigned int numNodes;
+    list<T*> fifo;
 };
 
+template<typename T>
+ZHashTable<T>::Storage::Storage(unsigned long int numBuckets):
+    buckets{nullptr},
+    numBuckets{numBuckets},
+    pool{},
+    numStores{0}
+{
+    void* ptr = mmap(nullptr, numBuckets * sizeof(Bucket), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ptr == MAP_FAILED)
+        throw bad_alloc();
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, numBuckets * sizeof(Bucket), MADV_HUGEPAGE);
+#endif
+    buckets = static_cast<Bucket*>(ptr);
+    for(unsigned long int i = 0; i < numBuckets; ++i)
+        new (buckets + i) Bucket{};
+}
+
+template<typename T>
+ZHashTable<T>::Storage::~Storage()
+{
+    // the buckets are trivially destructible
+    munmap(buckets, numBuckets * sizeof(Bucket));
+}
+
 // We could make constructor parameters dependent on the template type but the gains would be negligible
 template<typename T>
 ZHashTable<T>::ZHashTable(GameState* gameState, MAST* policy, unsigned int LenHashCode, unsigned int budget):
     LenHashCode{LenHashCode},
+    numBuckets{((2UL<<LenHashCode) + bucketSize - 1) / bucketSize},
+    table{make_shared<Storage>(numBuckets)},
+    buckets{table->buckets},
+    pool{&table->pool},
     currCode{0},
     currKey{0},
-    table{vector<list<T*>>(pow(2, LenHashCode), list<T*>())}
+    context{gameState, this, policy, nullptr, 0, {}, {}},
+    budget{budget},
+    numNodes{0}
 {
+    assertm(LenHashCode >= 2 and LenHashCode <= 30, "LenHashCode should be between 2 and 30");
+    assertm(!isRecycledType or budget < numBuckets * bucketSize, "budget should be smaller than the number of entries");
     unsigned int moveNum = gameState->moveNum();
+    // nodes are constructed from the context
+    bind();
     if constexpr(isRecycledType){
-        wType::template setup<T>(policy, gameState, this);
-        T::setup(budget);
         root = store();
-        T::fifo.push_back(root);
-        root->fifoPtr = T::fifo.end();
+        fifo.push_back(root);
+        root->fifoPtr = fifo.end();
         --(root->fifoPtr);
     }
     else{
-        T::setup(policy, gameState, this);
         // root is not in TT
-        root = new T(currKey);
+        root = allocate(currKey);
     }
 
     hashCodes.reserve(moveNum);
     hashKeys.reserve(moveNum);
-    // Mask to unset the most signifficant bits
-    hashCodeMask=(1L<<LenHashCode)-1;
 
-    std::random_device rd;
-    std::mt19937_64 eng(rd());
-    std::uniform_int_distribution<unsigned long int> distr;
+    Rng rng{Rng::ZobristStream};
 
     for(unsigned int i=0; i<moveNum; ++i)
     {
-        hashCodes.push_back(distr(eng));
-        // set the most significant bits to zero (masking) to have correct index mapping
-        hashCodes[i]&=hashCodeMask;
-        hashKeys.push_back(distr(eng));
+        // 32 bit codes, their xor is scaled to the number of buckets
+        hashCodes.push_back(rng() >> 32);
+        hashKeys.push_back(rng());
     }
 }
 
 template<typename T>
-void ZHashTable<T>::reset(){
-    for(auto& nodes : table){
-        for(T* p : nodes){
-            delete p;
+ZHashTable<T>::ZHashTable(ZHashTable* shared, GameState* gameState, MAST* policy):
+    LenHashCode{shared->LenHashCode},
+    numBuckets{shared->numBuckets},
+    table{shared->table},
+    buckets{shared->buckets},
+    pool{shared->pool},
+    hashCodes{shared->hashCodes},
+    hashKeys{shared->hashKeys},
+    currCode{shared->currCode},
+    currKey{shared->currKey},
+    root{shared->root},
+    context{gameState, this, policy, nullptr, shared->context.currDepth, {}, {}},
+    budget{shared->budget},
+    numNodes{0}
+{}
+
+template<typename T>
+ZHashTable<T>::~ZHashTable(){
+    // views share the nodes, only the last one deallocates them
+    if(table.use_count() > 1)
+        return;
+    if constexpr(!isRecycledType){
+        // root is not in TT
+        deallocate(root);
+    }
+    clear();
+}
+
+template<typename T>
+void ZHashTable<T>::clear(){
+    for(unsigned long int code = 0; code < numBuckets; ++code){
+        Bucket& bucket = buckets[code];
+        for(unsigned int i=0; i<bucketSize; ++i){
+            if(unsigned int handle = bucket.handles[i].load(memory_order_relaxed)){
+                pool->node(handle)->~T();
+                pool->generation(handle).fetch_add(1, memory_order_relaxed);
+            }
+            bucket.handles[i].store(0, memory_order_relaxed);
+            bucket.keys[i].store(0, memory_order_relaxed);
         }
-        nodes = list<T*>();
+        bucket.overflow.store(false, memory_order_relaxed);
     }
-    // reset static variables
-    Node<T>::currDepth = currCode = currKey = 0;
-    T::reset();
+    // the nodes are destructed, their memory is released at once
+    table->pool.clear();
+}
+
+template<typename T>
+void ZHashTable<T>::reset(){
+    if constexpr(!isRecycledType){
+        // root is not in TT
+        root->~T();
+    }
+    clear();
+    bind();
+    context.currDepth = currCode = currKey = 0;
+    context.data = {};
+    // a node evicted by the last store is released with the pool
+    context.rNode = nullptr;
 
     if constexpr(isRecycledType){
-        wType::reset();
+        fifo.clear();
+        numNodes = 0;
         root = store();
-        T::fifo.push_back(root);
-        root->fifoPtr = T::fifo.end();
+        fifo.push_back(root);
+        root->fifoPtr = fifo.end();
         --(root->fifoPtr);
     }
     else{
-        // root is not in TT
-        delete root;
-        root = new T(currKey);
+        root = allocate(currKey);
     }
 }
 
+template<typename T>
+void ZHashTable<T>::bind()
+{
+    Node<T>::context = &context;
+}
+
 template<typename T>
 void ZHashTable<T>::update(unsigned int moveIdx)
 {
@@ -141,86 +324,199 @@ void ZHashTable<T>::update(unsigned int moveIdx)
 template<typename T>
 T* ZHashTable<T>::load()
 {
-    for(auto p : table[currCode]){
-        if(p->key == currKey)
-            return p;
+    unsigned int handle;
+    return load(handle);
+}
+
+template<typename T>
+T* ZHashTable<T>::resolve(const ChildEdge& edge) const
+{
+    // the generation changes when the node is removed, before its memory can be reused
+    return pool->generation(edge.handle).load(memory_order_acquire) == edge.generation ? pool->node(edge.handle) : nullptr;
+}
+
+template<typename T>
+unsigned int ZHashTable<T>::generation(unsigned int handle) const
+{
+    return pool->generation(handle).load(memory_order_acquire);
+}
+
+template<typename T>
+inline T* ZHashTable<T>::load(unsigned int& handle)
+{
+    const unsigned long int key = currKey;
+    unsigned long int code = bucketOf(currCode);
+    // the overflow flags are only cleared by reset, the walk ends after every bucket at the latest
+    for(unsigned long int n = 0; n < numBuckets; ++n){
+        const Bucket& bucket = buckets[code];
+        for(unsigned int i=0; i<bucketSize; ++i){
+            if(bucket.keys[i].load(memory_order_relaxed) != key)
+                continue;
+            // the entry is read again under the version of the bucket, another thread could be writing it
+            unsigned short version = bucket.version.load(memory_order_acquire);
+            unsigned int entry = bucket.handles[i].load(memory_order_relaxed);
+            bool hit = entry and bucket.keys[i].load(memory_order_relaxed) == key;
+            atomic_thread_fence(memory_order_acquire);
+            if(version & 1 or bucket.version.load(memory_order_relaxed) != version){
+                // a store or an erase is writing the bucket, the entry is read again
+                --i;
+                continue;
+            }
+            if(hit){
+                handle = entry;
+                return pool->node(entry);
+            }
+        }
+        if(!bucket.overflow.load(memory_order_relaxed))
+            return nullptr;
+        code = nextBucket(code);
     }
     return nullptr;
 }
 
+template<typename T>
+T* ZHashTable<T>::allocate(unsigned long int key)
+{
+    T* node = new (pool->allocate(wType::extraSize(context.gameState->validMoves.size()))) T(key);
+    // the wrapped node finds its extra data after the object
+    assertm(static_cast<void*>(static_cast<wType*>(node)) == node, "wrapped node should be at the start of the object");
+    return node;
+}
+
+template<typename T>
+T* ZHashTable<T>::allocate(const T* node)
+{
+    size_t extraSize = node->extraSize();
+    T* copy = new (pool->allocate(extraSize)) T(*node);
+    memcpy(reinterpret_cast<char*>(copy) + sizeof(T), reinterpret_cast<const char*>(node) + sizeof(T), extraSize);
+    return copy;
+}
+
+template<typename T>
+void ZHashTable<T>::deallocate(T* node)
+{
+    size_t extraSize = node->extraSize();
+    node->~T();
+    pool->release(node, extraSize);
+}
+
+template<typename T>
+void ZHashTable<T>::insert(unsigned int slot, T* node)
+{
+    Bucket& bucket = buckets[slot / bucketSize];
+    assertm(!bucket.handles[slot % bucketSize].load(memory_order_relaxed), "slot should be empty");
+    unsigned short version = bucket.version.load(memory_order_relaxed);
+    bucket.version.store(version + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    bucket.handles[slot % bucketSize].store(pool->ref(node), memory_order_relaxed);
+    bucket.keys[slot % bucketSize].store(node->key, memory_order_relaxed);
+    // publishes the node with the entry
+    bucket.version.store(version + 2, memory_order_release);
+}
+
+template<typename T>
+void ZHashTable<T>::erase(unsigned int slot)
+{
+    Bucket& bucket = buckets[slot / bucketSize];
+    unsigned int handle = bucket.handles[slot % bucketSize].load(memory_order_relaxed);
+    unsigned short version = bucket.version.load(memory_order_relaxed);
+    bucket.version.store(version + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    bucket.handles[slot % bucketSize].store(0, memory_order_relaxed);
+    bucket.keys[slot % bucketSize].store(0, memory_order_relaxed);
+    bucket.version.store(version + 2, memory_order_release);
+    // child edges to the node become stale
+    pool->generation(handle).fetch_add(1, memory_order_release);
+}
+
 template<typename T>
 T* ZHashTable<T>::store()
 {
+    T* node = allocate(currKey);
+    table->numStores.fetch_add(1, memory_order_relaxed);
     // node recycling
     if constexpr(isRecycledType){
-        table[currCode].push_front(new T(currKey));
-        auto it = table[currCode].begin();
-        // provide iterators so RecyclingNode can deallocate itself
-        (*it)->listIt = it;
-        (*it)->listPtr = &(table[currCode]);
-        return *it;
+        ++numNodes;
+        // linear probing over the buckets, the budget keeps the table from filling up
+        unsigned long int code = bucketOf(currCode);
+        while(true){
+            Bucket& bucket = buckets[code];
+            for(unsigned int i=0; i<bucketSize; ++i){
+                if(!bucket.handles[i].load(memory_order_relaxed)){
+                    // provide the slot so RecyclingNode can deallocate itself
+                    node->slot = code * bucketSize + i;
+                    insert(node->slot, node);
+                    return node;
+                }
+            }
+            bucket.overflow.store(true, memory_order_relaxed);
+            code = nextBucket(code);
+        }
     }
     else{
-        // OneDepthVNew replacing scheme
-        if(table[currCode].size() == 2){
-            // reachable ? -> closer to root ? -> visit count ?
-            // node deallocation is postponed after backpropagation
-            if(table[currCode].front()->depth <= root->depth){
-                Node<T>::rNode = table[currCode].front();
-                table[currCode].pop_front();
-            }
-            else if(table[currCode].back()->depth <= root->depth){
-                Node<T>::rNode = table[currCode].back();
-                table[currCode].pop_back();
-            }
-            else if(table[currCode].front()->depth > table[currCode].back()->depth){
-                Node<T>::rNode = table[currCode].front();
-                table[currCode].pop_front();
-            }
-            else if(table[currCode].front()->depth < table[currCode].back()->depth){
-                Node<T>::rNode = table[currCode].back();
-                table[currCode].pop_back();
+        // OneDepthVNew replacing scheme generalized to the bucket size
+        unsigned long int code = bucketOf(currCode);
+        Bucket& bucket = buckets[code];
+        unsigned int victim = bucketSize;
+        T* rNode = nullptr;
+        for(unsigned int i=0; i<bucketSize; ++i){
+            unsigned int handle = bucket.handles[i].load(memory_order_relaxed);
+            if(!handle){
+                victim = i;
+                rNode = nullptr;
+                break;
             }
-            else if(table[currCode].front()->visitCount() < table[currCode].back()->visitCount()){
-                Node<T>::rNode = table[currCode].front();
-                table[currCode].pop_front();
+            T* other = pool->node(handle);
+            // reachable ? -> closer to root ? -> visit count ?
+            if(other->depth <= root->depth){
+                victim = i;
+                rNode = other;
+                break;
             }
-            else{
-                Node<T>::rNode = table[currCode].back();
-                table[currCode].pop_back();
+            if(!rNode or other->depth > rNode->depth or (other->depth == rNode->depth and other->visitCount() < rNode->visitCount())){
+                victim = i;
+                rNode = other;
             }
-            table[currCode].push_back(new T(currKey));
         }
-        else{
-            table[currCode].push_back(new T(currKey));
+        if(rNode){
+            // node deallocation is postponed after backpropagation
+            context.rNode = rNode;
+            erase(code * bucketSize + victim);
         }
-        return *(table[currCode].begin());
+        insert(code * bucketSize + victim, node);
+        return node;
     }
 }
 
 template<typename T>
 T* ZHashTable<T>::updateRoot(unsigned int moveIdx){
     update(moveIdx);
+    ++context.currDepth;
+    return advanceRoot();
+}
+
+template<typename T>
+T* ZHashTable<T>::advanceRoot(){
     if constexpr(isRecycledType){
-        (root->listPtr)->erase(root->listIt);
-        T::fifo.erase(root->fifoPtr);
+        erase(root->slot);
+        fifo.erase(root->fifoPtr);
+        --numNodes;
     }
-    delete root;
-    ++Node<T>::currDepth;
+    deallocate(root);
     root = load();
     if constexpr(isRecycledType){
         // no copy is needed, root is in the TT
         if(!root){
             root = store();
-            T::fifo.push_back(root);
-            root->fifoPtr = T::fifo.end();
+            fifo.push_back(root);
+            root->fifoPtr = fifo.end();
             --(root->fifoPtr);
         }
         return root;
     }
     else{
         // copy, root is not stored in TT
-        root = root ? new T(*root) : new T(currKey);
+        root = root ? allocate(root) : allocate(currKey);
         return root;
     }
 }